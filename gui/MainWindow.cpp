@@ -5,6 +5,7 @@
 #include <wx/datetime.h>
 #include <wx/msgdlg.h>
 #include <wx/timer.h>
+#include <wx/choicdlg.h>
 
 wxBEGIN_EVENT_TABLE(MainWindow, wxFrame)
     EVT_BUTTON(wxID_ANY, MainWindow::OnLogin)
@@ -366,10 +367,11 @@ void MainWindow::RefreshMainPanel() {
     // Clear existing posts
     postsSizer->Clear(true);
     
-    // Get and display posts
-    const auto& allPosts = fbSystem->getPosts();
-    for (const Post* post : allPosts) {
-        AddPostToPanel(post);
+    // Show the first page of the user's feed. AddPostToPanel inserts at the
+    // top, so add the page oldest-first to end up with the newest post on top.
+    FeedPage feed = fbSystem->getFeed(FeedCursor(), FEED_PAGE_SIZE);
+    for (auto it = feed.posts.rbegin(); it != feed.posts.rend(); ++it) {
+        AddPostToPanel(*it);
     }
     
     // Refresh friend requests
@@ -583,6 +585,24 @@ void MainWindow::OnAddFriend(wxCommandEvent& event)
             return;
         }
         
+        // Partial names fall back to the type-ahead index
+        if (!fbSystem->findUserByUsername(username.ToStdString())) {
+            auto matches = fbSystem->searchUsers(username.ToStdString(), 10);
+            if (matches.empty()) {
+                wxMessageBox("No users match \"" + username + "\"", "Error",
+                            wxOK | wxICON_ERROR);
+                return;
+            }
+            
+            wxArrayString choices;
+            for (const User* match : matches) {
+                choices.Add(match->getUsername());
+            }
+            wxSingleChoiceDialog picker(this, "Select a user:", "Add Friend", choices);
+            if (picker.ShowModal() != wxID_OK) return;
+            username = picker.GetStringSelection();
+        }
+        
         if (fbSystem->sendFriendRequest(username.ToStdString())) {
             wxMessageBox("Friend request sent!", "Success",
                         wxOK | wxICON_INFORMATION);
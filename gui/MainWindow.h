@@ -28,6 +28,9 @@ private:
         ID_NOTIFICATION_TIMER
     };
 
+    // Posts shown per feed refresh
+    static constexpr std::size_t FEED_PAGE_SIZE = 50;
+
     // UI Elements
     wxPanel* loginPanel;
     wxPanel* registerPanel;
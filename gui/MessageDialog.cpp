@@ -18,7 +18,7 @@ MessageDialog::MessageDialog(wxWindow* parent, FacebookSystem* fbSystem, const w
     UpdateUserList();
     
     if (!currentChatUser.IsEmpty()) {
-        userList->SetStringSelection(currentChatUser);
+        SelectUser(currentChatUser);
         UpdateChat();
     }
 }
@@ -37,6 +37,12 @@ void MessageDialog::CreateControls() {
     chatHistory = new wxRichTextCtrl(this, wxID_ANY, "", wxDefaultPosition,
                                    wxDefaultSize, wxRE_MULTILINE | wxRE_READONLY);
     chatSizer->Add(chatHistory, 1, wxEXPAND | wxALL, 5);
+    // Older messages are fetched when the user scrolls to the top
+    chatHistory->Bind(wxEVT_SCROLLWIN_TOP, &MessageDialog::OnChatScroll, this);
+    chatHistory->Bind(wxEVT_SCROLLWIN_LINEUP, &MessageDialog::OnChatScroll, this);
+    chatHistory->Bind(wxEVT_SCROLLWIN_PAGEUP, &MessageDialog::OnChatScroll, this);
+    chatHistory->Bind(wxEVT_SCROLLWIN_THUMBRELEASE, &MessageDialog::OnChatScroll, this);
+    chatHistory->Bind(wxEVT_MOUSEWHEEL, &MessageDialog::OnChatWheel, this);
     
     // Message input area
     wxBoxSizer* inputSizer = new wxBoxSizer(wxHORIZONTAL);
@@ -57,51 +63,128 @@ void MessageDialog::CreateControls() {
 
 void MessageDialog::UpdateUserList() {
     userList->Clear();
+    listedUsers.clear();
     
-    // Get current user's friends
-    const auto& friends = fbSystem->getCurrentUser()->getFriends();
-    for (const auto& friend_ : friends) {
-        userList->Append(friend_);
+    // Chats first, most recent on top, from the current user's inbox
+    for (const auto& chat : fbSystem->getInbox()) {
+        wxString label = chat.peer;
+        if (chat.unread > 0) {
+            label << " (" << static_cast<unsigned long>(chat.unread) << ")";
+        }
+        userList->Append(label);
+        listedUsers.push_back(chat.peer);
     }
     
-    // Get all users we've messaged with
-    const auto& conversations = fbSystem->getConversations();
-    for (const auto& [key, messages] : conversations) {
-        // Extract usernames from the conversation key
-        size_t pos = key.find('|');
-        if (pos != std::string::npos) {
-            std::string user1 = key.substr(0, pos);
-            std::string user2 = key.substr(pos + 1);
-            
-            // Add the other user if they're not already in the list
-            std::string otherUser = (user1 == fbSystem->getCurrentUser()->getUsername()) ? user2 : user1;
-            if (std::find(friends.begin(), friends.end(), otherUser) == friends.end() &&
-                userList->FindString(otherUser) == wxNOT_FOUND) {
-                userList->Append(otherUser);
-            }
+    // Then friends we have not messaged yet
+    for (const auto& friend_ : fbSystem->getCurrentUser()->getFriends()) {
+        if (std::find(listedUsers.begin(), listedUsers.end(), wxString(friend_)) == listedUsers.end()) {
+            userList->Append(friend_);
+            listedUsers.push_back(friend_);
         }
     }
 }
 
+void MessageDialog::SelectUser(const wxString& username) {
+    auto it = std::find(listedUsers.begin(), listedUsers.end(), username);
+    if (it != listedUsers.end()) {
+        userList->SetSelection(static_cast<int>(it - listedUsers.begin()));
+    }
+}
+
+void MessageDialog::WriteMessage(const ChatMessage& message) {
+    chatHistory->BeginBold();
+    chatHistory->WriteText(User::nameOf(message.from));
+    chatHistory->EndBold();
+    chatHistory->WriteText(": " + std::string(message.text) + "\n");
+}
+
 void MessageDialog::UpdateChat() {
     chatHistory->Clear();
+    olderPage = MessageCursor();
+    hasOlder = false;
+    shownEnd = 0;
     
     if (currentChatUser.IsEmpty()) return;
     
-    const auto& messages = fbSystem->getMessages(currentChatUser.ToStdString());
-    for (const auto& msg : messages) {
-        chatHistory->BeginBold();
-        chatHistory->WriteText(msg.first);
-        chatHistory->EndBold();
-        chatHistory->WriteText(": " + msg.second + "\n");
+    // Only the newest page is drawn; older ones are loaded on scroll
+    MessagePage page = fbSystem->getMessages(currentChatUser.ToStdString(), MessageCursor(), PAGE_SIZE);
+    chatHistory->Freeze();
+    for (const ChatMessage& msg : page.messages) {
+        WriteMessage(msg);
     }
+    chatHistory->Thaw();
+    olderPage = page.next;
+    hasOlder = page.hasMore;
+    shownEnd = page.messages.endPosition();
     
     chatHistory->ShowPosition(chatHistory->GetLastPosition());
     sendButton->Enable(true);
+
+    // Opening the chat reads it; drop the row's unread count
+    fbSystem->markConversationRead(currentChatUser.ToStdString());
+    auto row = std::find(listedUsers.begin(), listedUsers.end(), currentChatUser);
+    if (row != listedUsers.end()) {
+        userList->SetString(static_cast<unsigned int>(row - listedUsers.begin()), currentChatUser);
+    }
+}
+
+void MessageDialog::AppendNewMessages() {
+    if (currentChatUser.IsEmpty()) return;
+
+    MessageRange added = fbSystem->getMessages(currentChatUser.ToStdString()).after(shownEnd);
+    if (added.empty()) return;
+    chatHistory->SetInsertionPointEnd();
+    for (const ChatMessage& msg : added) {
+        WriteMessage(msg);
+    }
+    shownEnd = added.endPosition();
+    chatHistory->ShowPosition(chatHistory->GetLastPosition());
+}
+
+void MessageDialog::LoadOlderMessages() {
+    if (currentChatUser.IsEmpty() || !hasOlder) return;
+
+    MessagePage page = fbSystem->getMessages(currentChatUser.ToStdString(), olderPage, PAGE_SIZE);
+    if (page.messages.empty()) return;
+
+    // Insert above what is shown, then scroll back to where the reader was
+    long firstVisible = chatHistory->GetFirstVisiblePosition();
+    long before = chatHistory->GetLastPosition();
+    chatHistory->Freeze();
+    chatHistory->SetInsertionPoint(0);
+    for (const ChatMessage& msg : page.messages) {
+        WriteMessage(msg);
+    }
+    chatHistory->SetInsertionPointEnd();
+    chatHistory->Thaw();
+    chatHistory->ShowPosition(firstVisible + chatHistory->GetLastPosition() - before);
+
+    olderPage = page.next;
+    hasOlder = page.hasMore;
+}
+
+void MessageDialog::OnChatScroll(wxScrollWinEvent& event) {
+    event.Skip();
+    if (event.GetOrientation() == wxVERTICAL) {
+        CallAfter([this] {
+            if (chatHistory->GetScrollPos(wxVERTICAL) == 0) LoadOlderMessages();
+        });
+    }
+}
+
+void MessageDialog::OnChatWheel(wxMouseEvent& event) {
+    event.Skip();
+    if (event.GetWheelRotation() > 0) {
+        CallAfter([this] {
+            if (chatHistory->GetScrollPos(wxVERTICAL) == 0) LoadOlderMessages();
+        });
+    }
 }
 
 void MessageDialog::OnUserSelect(wxCommandEvent& event) {
-    currentChatUser = event.GetString();
+    int row = event.GetSelection();
+    if (row < 0 || static_cast<std::size_t>(row) >= listedUsers.size()) return;
+    currentChatUser = listedUsers[row];
     UpdateChat();
 }
 
@@ -112,7 +195,10 @@ void MessageDialog::OnSend(wxCommandEvent& event) {
         fbSystem->sendMessage(currentChatUser.ToStdString(), 
                             messageInput->GetValue().ToStdString());
         messageInput->Clear();
-        UpdateChat();
+        AppendNewMessages();
+        // The chat moves to the top of the inbox
+        UpdateUserList();
+        SelectUser(currentChatUser);
     } catch (const std::exception& e) {
         wxMessageBox(e.what(), "Error", wxOK | wxICON_ERROR);
     }
@@ -9,8 +9,16 @@ public:
     MessageDialog(wxWindow* parent, FacebookSystem* fbSystem, const wxString& withUser = "");
 
 private:
+    static constexpr std::size_t PAGE_SIZE = 50;
+
     FacebookSystem* fbSystem;
     wxString currentChatUser;
+    // Username of each row in userList; rows may carry an unread count
+    std::vector<wxString> listedUsers;
+    // The chat shows log positions [olderPage.before, shownEnd)
+    MessageCursor olderPage;
+    bool hasOlder = false;
+    std::size_t shownEnd = 0;
     
     // UI Components
     wxListBox* userList;
@@ -20,11 +28,18 @@ private:
     
     void CreateControls();
     void UpdateUserList();
+    void SelectUser(const wxString& username);
     void UpdateChat();
+    // Appends messages sent since the chat was last drawn
+    void AppendNewMessages();
+    void LoadOlderMessages();
+    void WriteMessage(const ChatMessage& message);
     
     // Event handlers
     void OnUserSelect(wxCommandEvent& event);
     void OnSend(wxCommandEvent& event);
+    void OnChatScroll(wxScrollWinEvent& event);
+    void OnChatWheel(wxMouseEvent& event);
     
     DECLARE_EVENT_TABLE()
 };
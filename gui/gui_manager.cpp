@@ -539,7 +539,7 @@ void GUIManager::showMainWindow(bool* p_open, FacebookSystem& fbSystem) {
         ImGui::PopFont();
         ImGui::Separator();
 
-        auto posts = fbSystem.getPosts();
+        auto posts = fbSystem.getFeed().posts;
         if (posts.empty()) {
             ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "No posts yet");
         } else {
@@ -0,0 +1,22 @@
+#ifndef ATOMICFILE_H
+#define ATOMICFILE_H
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+// Whole-file replacement that never leaves a torn file behind: the bytes go
+// to "<path>.tmp", are flushed to disk, and the temp file is then renamed
+// over path and the directory synced. A crash leaves either the old or the
+// new contents.
+class AtomicFile {
+public:
+    static bool write(const std::string& path, std::string_view bytes);
+    // Flushes the stream and forces its data to disk
+    static void sync(std::FILE* file);
+    // Forces the entries of the directory holding path (renames, creations,
+    // removals) to disk; a no-op where directories cannot be synced
+    static void syncDirectory(const std::string& path);
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef BACKGROUNDWRITER_H
+#define BACKGROUNDWRITER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Runs persistence jobs on one worker thread, in submission order. Jobs are
+// keyed: submitting under a key that is still queued drops the older job,
+// so a burst of saves of the same thing collapses into the newest one.
+// Jobs must own everything they touch; they run concurrently with the caller.
+class BackgroundWriter {
+private:
+    struct Job {
+        std::string key;
+        std::function<void()> run;
+    };
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::deque<Job> queue;
+    bool busy = false;
+    bool stopping = false;
+    std::size_t completed = 0;
+    std::thread worker;
+
+    void loop();
+
+public:
+    BackgroundWriter();
+    // Finishes every queued job before returning
+    ~BackgroundWriter();
+
+    BackgroundWriter(const BackgroundWriter&) = delete;
+    BackgroundWriter& operator=(const BackgroundWriter&) = delete;
+
+    void submit(const std::string& key, std::function<void()> job);
+    // Blocks until every job submitted so far has finished
+    void flush();
+
+    std::size_t pending() const;
+    std::size_t completedJobs() const;
+};
+
+#endif
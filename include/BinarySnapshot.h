@@ -0,0 +1,160 @@
+#ifndef BINARYSNAPSHOT_H
+#define BINARYSNAPSHOT_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "MappedFile.h"
+
+class User;
+class Post;
+
+// Versioned binary image of the data set, read in place through a MappedFile.
+//
+// Layout (native endianness, every section 8-byte aligned):
+//   Header
+//   UserRecord[userCount]
+//   uint64 friendOffsets[userCount + 1]   CSR adjacency: friends of user i are
+//   uint32 friends[friendCount]           friends[friendOffsets[i], friendOffsets[i+1])
+//   PostRecord[postCount]
+//   uint64 likeOffsets[postCount + 1]     likers of post i, same scheme
+//   uint32 likes[likeCount]
+//   MessageRecord[messageCount]
+//   char strings[stringsSize]             every string field, referenced by StringRef
+//
+// Friend and like entries are indices into the user records. The header also
+// records the sizes and content hashes of the text files written in the same
+// checkpoint, so a snapshot that no longer matches the text files is ignored.
+class BinarySnapshot {
+public:
+    static constexpr std::uint32_t VERSION = 2;
+    static constexpr std::size_t TEXT_FILES = 5;  // users, posts, friends, likes, messages
+    using TextSizes = std::array<std::uint64_t, TEXT_FILES>;
+    using TextHashes = std::array<std::uint64_t, TEXT_FILES>;
+
+    struct StringRef {
+        std::uint64_t offset;
+        std::uint32_t length;
+        std::uint32_t reserved;
+    };
+
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t headerSize;
+        std::uint64_t fileSize;
+        std::uint64_t textSizes[TEXT_FILES];
+        std::uint64_t textHashes[TEXT_FILES];
+        std::uint64_t userCount;
+        std::uint64_t postCount;
+        std::uint64_t messageCount;
+        std::uint64_t friendCount;
+        std::uint64_t likeCount;
+        std::uint64_t usersOffset;
+        std::uint64_t friendOffsetsOffset;
+        std::uint64_t friendsOffset;
+        std::uint64_t postsOffset;
+        std::uint64_t likeOffsetsOffset;
+        std::uint64_t likesOffset;
+        std::uint64_t messagesOffset;
+        std::uint64_t stringsOffset;
+        std::uint64_t stringsSize;
+    };
+
+    struct UserRecord {
+        StringRef username;
+        StringRef email;
+        StringRef password;
+        StringRef gender;
+        std::uint32_t flags;  // StorageEngine::UserFlags
+        std::uint32_t reserved;
+    };
+
+    struct PostRecord {
+        std::int32_t id;
+        std::uint32_t author;  // user index
+        std::uint32_t privacy;
+        std::uint32_t reserved;
+        StringRef timestamp;
+        StringRef content;
+    };
+
+    struct MessageRecord {
+        StringRef from;
+        StringRef to;
+        StringRef text;
+        StringRef timestamp;
+    };
+
+    // A message as handed to write() and returned by message()
+    struct Message {
+        std::string_view from;
+        std::string_view to;
+        std::string_view text;
+        std::string_view timestamp;
+    };
+
+    struct IndexRange {
+        const std::uint32_t* first;
+        const std::uint32_t* last;
+        const std::uint32_t* begin() const { return first; }
+        const std::uint32_t* end() const { return last; }
+        std::size_t size() const { return static_cast<std::size_t>(last - first); }
+    };
+
+private:
+    MappedFile file;
+    const Header* head = nullptr;
+    const UserRecord* users = nullptr;
+    const std::uint64_t* friendOffsets = nullptr;
+    const std::uint32_t* friends = nullptr;
+    const PostRecord* posts = nullptr;
+    const std::uint64_t* likeOffsets = nullptr;
+    const std::uint32_t* likes = nullptr;
+    const MessageRecord* messages = nullptr;
+    const char* strings = nullptr;
+
+    IndexRange range(const std::uint64_t* offsets, const std::uint32_t* values,
+                     std::size_t i, std::uint64_t total) const;
+
+public:
+    // The complete file contents for a snapshot of the given data
+    static std::string encode(const std::vector<User*>& users,
+                              const std::vector<Post*>& posts,
+                              const std::vector<Message>& messages,
+                              const TextSizes& textSizes, const TextHashes& textHashes);
+    // Encodes a snapshot and replaces path with it atomically
+    static bool write(const std::string& path,
+                      const std::vector<User*>& users,
+                      const std::vector<Post*>& posts,
+                      const std::vector<Message>& messages,
+                      const TextSizes& textSizes, const TextHashes& textHashes);
+
+    // Maps the file and validates its header and section bounds
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return head != nullptr; }
+
+    const Header& header() const { return *head; }
+    // Sizes are a cheap first check; equal sizes do not prove equal contents
+    bool matches(const TextSizes& textSizes) const;
+    bool matchesContent(const TextHashes& textHashes) const;
+
+    std::size_t userCount() const { return head ? head->userCount : 0; }
+    const UserRecord& user(std::size_t i) const { return users[i]; }
+    IndexRange friendsOf(std::size_t i) const { return range(friendOffsets, friends, i, head->friendCount); }
+
+    std::size_t postCount() const { return head ? head->postCount : 0; }
+    const PostRecord& post(std::size_t i) const { return posts[i]; }
+    IndexRange likesOf(std::size_t i) const { return range(likeOffsets, likes, i, head->likeCount); }
+
+    std::size_t messageCount() const { return head ? head->messageCount : 0; }
+    Message message(std::size_t i) const;
+
+    // Views into the mapping; empty if the reference is out of bounds
+    std::string_view str(const StringRef& ref) const;
+};
+
+#endif
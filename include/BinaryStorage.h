@@ -0,0 +1,34 @@
+#ifndef BINARYSTORAGE_H
+#define BINARYSTORAGE_H
+
+#include <string>
+#include "StorageEngine.h"
+#include "TextStorage.h"
+
+// Fast backend: the whole data set as one BinarySnapshot, read in place from
+// a memory mapping. When paired with a TextStorage the snapshot records the
+// text files' sizes and content hashes at save time, and load() refuses a
+// snapshot that no longer matches them (the text files were edited or
+// rewritten since, or a checkpoint committed them but not the snapshot).
+//
+// A snapshot always holds every entity, so encode() needs a complete Dataset.
+// The sizes and hashes it records are the ones the text files will have once
+// every text image encoded so far is committed (TextStorage::expectedSizes
+// and expectedHashes), so the snapshot is only valid if it is committed after
+// them.
+class BinaryStorage : public StorageEngine {
+private:
+    std::string path;
+    const TextStorage* text;
+
+public:
+    explicit BinaryStorage(const std::string& path, const TextStorage* text = nullptr);
+
+    const char* name() const override { return "binary"; }
+    bool load(Sink& sink, unsigned entities = ALL, StartupReport* report = nullptr) override;
+    bool encode(const Dataset& data, FileImages& images) override;
+
+    const std::string& getPath() const { return path; }
+};
+
+#endif
@@ -4,10 +4,12 @@
 #include <vector>
 #include <algorithm>
 #include "IReactable.h"
+#include "Versioned.h"
+#include "ObjectPool.h"
 
 class User;
 
-class Comment : public IReactable {
+class Comment : public IReactable, public Versioned {
 private:
     static inline int commentCounter = 0;
     int commentId;
@@ -23,6 +25,10 @@ public:
 
     ~Comment();
 
+    // Allocated from ObjectPool<Comment>
+    static void* operator new(std::size_t size) { return ObjectPool<Comment>::shared().allocate(size); }
+    static void operator delete(void* p, std::size_t size) { ObjectPool<Comment>::shared().deallocate(p, size); }
+
     // Getters
     int getId() const { return commentId; }
     User* getAuthor() const { return author; }
@@ -39,6 +45,6 @@ public:
     void addLike(User* user) override;
     void removeLike(User* user) override;
 
-    void setContent(const std::string& newContent) { content = newContent; }
-    void setTimestamp(const std::string& newTimestamp) { timestamp = newTimestamp; }
+    void setContent(const std::string& newContent) { content = newContent; touch(); }
+    void setTimestamp(const std::string& newTimestamp) { timestamp = newTimestamp; touch(); }
 };
@@ -2,10 +2,11 @@
 
 #include <vector>
 #include "Message.h"
+#include "Versioned.h"
 
 class User;
 
-class Conversation {
+class Conversation : public Versioned {
 private:
     static inline int nextId = 0;
     int id;
@@ -27,6 +28,7 @@ public:
     
     void addMessage(Message* message) {
         messages.push_back(message);
+        touch();
     }
 
     bool hasParticipant(User* user) const {
@@ -0,0 +1,187 @@
+#ifndef CONVERSATIONSTORE_H
+#define CONVERSATIONSTORE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "UserId.h"
+#include "Versioned.h"
+
+// A stored message as handed out by MessageLog. text points into the log's
+// arena and stays valid while the log exists.
+struct ChatMessage {
+    UserId from;
+    std::int64_t epoch;  // send time, see Timestamp::toEpoch
+    std::string_view text;
+};
+
+// The two participants of a direct conversation, smaller id first, so both
+// directions of a chat map to the same key
+struct ConversationKey {
+    UserId low = INVALID_USER_ID;
+    UserId high = INVALID_USER_ID;
+
+    static ConversationKey of(UserId a, UserId b) { return a < b ? ConversationKey{a, b} : ConversationKey{b, a}; }
+    bool involves(UserId user) const { return user == low || user == high; }
+    // The other participant; only meaningful if involves(self)
+    UserId peerOf(UserId self) const { return self == low ? high : low; }
+    bool operator==(const ConversationKey& other) const { return low == other.low && high == other.high; }
+};
+
+struct ConversationKeyHash {
+    std::size_t operator()(const ConversationKey& key) const {
+        std::uint64_t packed = (static_cast<std::uint64_t>(key.low) << 32) | key.high;
+        return static_cast<std::size_t>(packed * 0x9E3779B97F4A7C15ull >> 16);
+    }
+};
+
+// One conversation's messages in send order. Each message is a fixed-size
+// record (sender, send time, where its text is) appended into chunks that
+// are never reallocated; the texts are packed into a per-conversation arena
+// of blocks that double in size, so a message costs its record plus its
+// bytes and nothing stored ever moves.
+class MessageLog : public Versioned {
+public:
+    static constexpr std::size_t CHUNK_SIZE = 256;
+    static constexpr std::size_t FIRST_BLOCK = 256;
+    static constexpr std::size_t MAX_BLOCK = 64 * 1024;
+
+    struct Record {
+        std::int64_t epoch;
+        UserId from;
+        std::uint32_t block;
+        std::uint32_t offset;
+        std::uint32_t length;
+    };
+
+private:
+    std::vector<std::vector<Record>> chunks;
+    std::size_t count = 0;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    std::size_t blockSize = 0;  // capacity of blocks.back()
+    std::size_t blockUsed = 0;
+    std::size_t arenaBytes = 0;
+
+    const Record& record(std::size_t i) const { return chunks[i / CHUNK_SIZE][i % CHUNK_SIZE]; }
+
+public:
+    void append(UserId from, std::int64_t epoch, std::string_view text);
+
+    ChatMessage operator[](std::size_t i) const {
+        const Record& r = record(i);
+        return {r.from, r.epoch, std::string_view(blocks[r.block].get() + r.offset, r.length)};
+    }
+    UserId senderOf(std::size_t i) const { return record(i).from; }
+    std::int64_t epochOf(std::size_t i) const { return record(i).epoch; }
+    // Position of the first message sent at or after epoch. Messages are
+    // searched in send order, which is time order for anything sent through
+    // FacebookSystem.
+    std::size_t positionAt(std::int64_t epoch) const;
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    // Bytes held by records and text blocks
+    std::size_t memoryUsage() const { return chunks.size() * CHUNK_SIZE * sizeof(Record) + arenaBytes; }
+};
+
+// Non-owning view of messages [first, last) of a MessageLog; valid while the
+// log exists (appends do not invalidate it, they are just not included)
+class MessageRange {
+private:
+    const MessageLog* log = nullptr;
+    std::size_t first = 0;
+    std::size_t last = 0;
+
+public:
+    class const_iterator {
+    private:
+        const MessageLog* log;
+        std::size_t i;
+
+    public:
+        // Messages are assembled on dereference, so this is an input iterator
+        using iterator_category = std::input_iterator_tag;
+        using value_type = ChatMessage;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = ChatMessage;
+
+        const_iterator(const MessageLog* log, std::size_t i) : log(log), i(i) {}
+        reference operator*() const { return (*log)[i]; }
+        const_iterator& operator++() { ++i; return *this; }
+        const_iterator operator++(int) { const_iterator old = *this; ++i; return old; }
+        bool operator==(const const_iterator& other) const { return i == other.i; }
+        bool operator!=(const const_iterator& other) const { return i != other.i; }
+    };
+
+    MessageRange() = default;
+    MessageRange(const MessageLog& log, std::size_t first, std::size_t last)
+        : log(&log), first(first), last(last) {}
+    explicit MessageRange(const MessageLog& log) : MessageRange(log, 0, log.size()) {}
+
+    const_iterator begin() const { return {log, first}; }
+    const_iterator end() const { return {log, last}; }
+    // Positions in the log, which never change since it is append-only
+    std::size_t beginPosition() const { return first; }
+    std::size_t endPosition() const { return last; }
+    // The messages at log positions >= position
+    MessageRange after(std::size_t position) const {
+        return log ? MessageRange(*log, std::max(first, std::min(position, last)), last) : MessageRange();
+    }
+    ChatMessage operator[](std::size_t i) const { return (*log)[first + i]; }
+    ChatMessage back() const { return (*log)[last - 1]; }
+    std::size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+};
+
+// Position in a conversation: the log position of the oldest message already
+// returned. A default-constructed cursor starts at the newest message.
+struct MessageCursor {
+    std::size_t before = std::numeric_limits<std::size_t>::max();
+
+    bool atEnd() const { return before == std::numeric_limits<std::size_t>::max(); }
+};
+
+struct MessagePage {
+    MessageRange messages;  // oldest first, like the conversation
+    MessageCursor next;     // pass back to fetch the older page before this one
+    bool hasMore = false;
+};
+
+// Direct conversations keyed by participant ids
+class ConversationStore {
+private:
+    using Map = std::unordered_map<ConversationKey, MessageLog, ConversationKeyHash>;
+    Map logs;
+    std::size_t messages = 0;
+
+public:
+    void append(UserId from, UserId to, std::int64_t epoch, std::string_view text);
+
+    // nullptr if the two have never exchanged a message
+    const MessageLog* find(UserId a, UserId b) const;
+    // The whole conversation, oldest first; empty if there is none
+    MessageRange messagesBetween(UserId a, UserId b) const;
+    // The part of it sent with fromEpoch <= time < toEpoch
+    MessageRange messagesBetween(UserId a, UserId b, std::int64_t fromEpoch, std::int64_t toEpoch) const;
+    // Up to limit messages ending just before the cursor, so a chat opens
+    // with its newest page and pages backwards; cost is independent of length
+    MessagePage page(UserId a, UserId b, const MessageCursor& cursor, std::size_t limit) const;
+
+    std::size_t size() const { return logs.size(); }
+    std::size_t messageCount() const { return messages; }
+    bool empty() const { return logs.empty(); }
+    void clear();
+
+    Map::const_iterator begin() const { return logs.begin(); }
+    Map::const_iterator end() const { return logs.end(); }
+};
+
+#endif
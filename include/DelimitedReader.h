@@ -0,0 +1,61 @@
+#ifndef DELIMITEDREADER_H
+#define DELIMITEDREADER_H
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include "MappedFile.h"
+
+// Streaming reader for the '|'-delimited data files. The file is mapped (or,
+// failing that, read into one buffer) and records are handed out as
+// string_views into it, so parsing allocates nothing per line. Delimiter
+// search scans 16 bytes at a time for '|' and '\n' together.
+//
+// Empty lines are skipped and a trailing '\r' is dropped, matching what the
+// getline-based loaders accepted.
+class DelimitedReader {
+public:
+    static constexpr std::size_t MAX_FIELDS = 16;
+
+    struct Record {
+        std::array<std::string_view, MAX_FIELDS> fields;
+        std::size_t count = 0;
+        std::size_t line = 0;  // 1-based line number in the file
+
+        std::size_t size() const { return count; }
+        std::string_view operator[](std::size_t i) const { return fields[i]; }
+    };
+
+private:
+    MappedFile mapping;
+    std::string buffer;  // used when the file cannot be mapped
+    const char* begin = nullptr;
+    const char* cursor = nullptr;
+    const char* end = nullptr;
+    char delimiter;
+    std::size_t lineNumber = 0;
+
+public:
+    explicit DelimitedReader(char delimiter = '|') : delimiter(delimiter) {}
+
+    // False if the file cannot be opened; an empty file opens with no records
+    bool open(const std::string& path);
+    // Reads records from [first, last) in memory owned by the caller
+    void attach(const char* first, const char* last);
+
+    // The bytes being read, valid while the reader is open
+    const char* data() const { return begin; }
+    std::size_t size() const { return static_cast<std::size_t>(end - begin); }
+
+    // Reads the next non-empty line. At most maxFields fields are split off;
+    // the last one keeps the rest of the line, delimiters included.
+    bool next(Record& record, std::size_t maxFields = MAX_FIELDS);
+
+    std::size_t linesRead() const { return lineNumber; }
+
+    // First delimiter or '\n' in [first, last), or last if there is none
+    static const char* findDelimiter(const char* first, const char* last, char delimiter);
+};
+
+#endif
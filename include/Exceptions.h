@@ -25,6 +25,13 @@ public:
     }
 };
 
+class UserAlreadyExistsException : public std::exception {
+public:
+    const char* what() const noexcept override {
+        return "Username or email already exists";
+    }
+};
+
 class AuthenticationException : public std::exception {
 public:
     const char* what() const noexcept override {
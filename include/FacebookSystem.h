@@ -5,27 +5,119 @@
 #include "Post.h"
 #include "Conversation.h"
 #include "Message.h"
+#include "UserDirectory.h"
+#include "MutualFriends.h"
+#include "PostStore.h"
+#include "PostSearchIndex.h"
+#include "FeedService.h"
+#include "TimelineCache.h"
+#include "WriteAheadLog.h"
+#include "StartupLoader.h"
+#include "StorageEngine.h"
+#include "TextStorage.h"
+#include "BinaryStorage.h"
+#include "BackgroundWriter.h"
+#include "ConversationStore.h"
+#include "MessageArchive.h"
+#include "Versioned.h"
+#include <array>
+#include <atomic>
 #include <vector>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <chrono>
 #include <ctime>
 
-class FacebookSystem {
+// Loads itself through the storage engines' Sink interface (privately, so the
+// callbacks are not part of the public API)
+class FacebookSystem : private StorageEngine::Sink {
+public:
+    static constexpr const char* DATA_DIR = "../data";
+    static constexpr const char* WAL_FILE = "../data/wal.log";
+    static constexpr const char* SNAPSHOT_FILE = "../data/snapshot.bin";
+    static constexpr const char* MESSAGES_DIR = "../data/messages";
+    static constexpr std::size_t WAL_COMPACT_THRESHOLD = 1000;
+
 private:
-    std::vector<User*> users;
-    std::vector<Post*> posts;
+    UserDirectory users;
+    PostStore posts;
+    PostSearchIndex searchIndex;
+    TimelineCache timelines;
+    WriteAheadLog wal;
+    TextStorage textStorage;
+    BinaryStorage binaryStorage;
+    // Writes encoded files off the calling thread
+    BackgroundWriter writer;
+    std::uint64_t checkpointGeneration = 0;  // last retired log generation
+    // Dirty tracking, by text file (entity bit index): the Versioned clock
+    // when each was last encoded, and entities to rewrite regardless
+    std::array<std::uint64_t, TextStorage::FILE_COUNT> savedAt{};
+    unsigned forcedDirty = 0;
+    std::uint64_t postsRemovedAt = 0;
+    // The snapshot lags the text files, or retired logs are still on disk
+    bool snapshotStale = false;
+    // Set by a background save that failed, until a full rewrite succeeds;
+    // until then retired logs are kept
+    std::atomic<bool> saveFailed{false};
+    // File/log post id -> loaded post, only valid while loading
+    std::unordered_map<int, Post*> loadedPostIds;
+    // Hash of (author, timestamp, content) -> loaded post, to drop repeated rows
+    std::unordered_multimap<std::size_t, Post*> loadedPostKeys;
+    std::size_t droppedDuplicatePosts = 0;
+    std::string loadKey;  // reused for lookups and timestamp parsing while loading
+    StartupReport startupReport;
     std::map<std::string, std::vector<std::string>> notifications;
-    std::map<std::string, std::vector<std::pair<std::string, std::string>>> conversations;
+    // Every message is in the archive; the store holds the conversations
+    // opened since login
+    MessageArchive archive;
+    ConversationStore conversations;
+    // Messages found in the data files, which predate the archive; they are
+    // imported if the archive is new and dropped from the files either way
+    bool importingMessages = false;
+    std::size_t legacyMessages = 0;
     User* currentUser;
 
     void AddDefaultBots();
     void CreateDefaultBots();
     void CreateBotPosts(User* bot);
-    std::string createChatKey(const std::string& user1, const std::string& user2) const;
     void createDefaultUsers();
     void SendBotFriendRequests();
     std::string getCurrentTimestamp() const;
+    // Adds/removes a post in the store (which owns it), its author's list and
+    // the search index; storePost returns the stored post or nullptr
+    Post* storePost(std::unique_ptr<Post> post);
+    void unstorePost(Post* post);
+    // Stores a persisted post under its saved id unless the same author already
+    // has a post with this timestamp and content; returns the post the id maps to
+    Post* restorePost(int savedId, User* author, const std::string& content,
+                      const std::string& timestamp, PostPrivacy privacy);
+    void forgetLoadedPost(Post* post);
+
+    // Appends to the write-ahead log; compacts once it grows past the threshold
+    void logMutation(const WriteAheadLog::Record& record);
+    std::size_t replayLog();
+    void applyLogRecord(const WriteAheadLog::Record& record);
+    // Loads or saves the given StorageEngine::Entity bits through engine
+    bool loadFrom(StorageEngine& engine, unsigned entities, StartupReport* report = nullptr);
+    bool encodeTo(StorageEngine& engine, unsigned entities, StorageEngine::FileImages& images);
+    // Encodes the changed text files among entities now and writes them in
+    // the background
+    void saveText(unsigned entities);
+    // StorageEngine::Entity bits changed since they were last encoded
+    unsigned dirtyEntities() const;
+    void markSaved(unsigned entities);
+    User* findLoadedUser(std::string_view username);
+    // Reads the current user's conversation with other from the archive the
+    // first time it is needed
+    void openConversation(const std::string& other);
+
+    // StorageEngine::Sink
+    void user(const StorageEngine::UserRow& row) override;
+    void post(const StorageEngine::PostRow& row) override;
+    void like(const StorageEngine::LikeRow& row) override;
+    void friendship(const StorageEngine::FriendshipRow& row) override;
+    void message(const StorageEngine::MessageRow& row) override;
 
 public:
     FacebookSystem();
@@ -39,6 +131,14 @@ public:
     void saveUsersToFile();
     void saveFriends();
     void savePosts();
+    void loadLikes();
+    void saveLikes();
+    // Captures the changed text files and the snapshot and retires the log;
+    // the files are written in the background. Does no I/O if nothing changed.
+    void checkpoint();
+    bool hasUnsavedChanges() const;
+    // Blocks until every background save has reached the disk
+    void flush();
 
     bool login(const std::string& email, const std::string& password);
     void logout();
@@ -54,9 +154,16 @@ public:
     void likePost(int postId);
     void commentOnPost(int postId, const std::string& comment);
     void sharePost(int postId);
+    bool deletePost(int postId);
+    Post* findPostById(int postId) const { return posts.findById(postId); }
 
+    // The current user's timeline (own and friends' posts), newest first
+    FeedPage getFeed(const FeedCursor& cursor = FeedCursor(), std::size_t pageSize = 20);
     std::vector<Post*> searchPosts(const std::string& query) const;
-    std::vector<User*> searchUsers(const std::string& query) const;
+    // Posts the current user may see with fromEpoch <= time < toEpoch, newest first
+    std::vector<Post*> getPostsBetween(std::int64_t fromEpoch, std::int64_t toEpoch) const;
+    // Case-insensitive type-ahead: prefix matches first, then infix; limit == 0 returns all
+    std::vector<User*> searchUsers(const std::string& query, std::size_t limit = 0) const;
     
     bool sendFriendRequest(const std::string& username);
     void acceptFriendRequest(const std::string& username);
@@ -64,21 +171,36 @@ public:
     void removeFriend(const std::string& username);
     bool areFriends(const User* user1, const User* user2) const;
     bool hasPendingFriendRequest(const User* fromUser, const User* toUser) const;
+    std::vector<User*> getMutualFriends(const std::string& username) const;
+    std::vector<FriendSuggestion> suggestFriends(std::size_t count = 10) const;
     User* findUserByUsername(const std::string& username) const;
     User* findUserByEmail(const std::string& email) const;
     bool isValidEmail(const std::string& email) const;
     
     void sendMessage(const std::string& to, const std::string& message);
-    std::vector<std::pair<std::string, std::string>> getMessages(const std::string& withUsername) const;
+    // The conversation with withUsername, oldest first; a view into the store
+    // that stays valid until logout
+    MessageRange getMessages(const std::string& withUsername);
+    // The newest limit messages before the cursor, and the cursor for the
+    // page before them
+    MessagePage getMessages(const std::string& withUsername, const MessageCursor& before,
+                            std::size_t limit);
+    // The current user's conversations, most recently active first, with the
+    // last message's preview and unread counts; limit == 0 returns all
+    std::vector<MessageArchive::InboxEntry> getInbox(std::size_t limit = 0) const;
+    std::size_t getUnreadMessageCount() const;
+    // Marks everything in the conversation with withUsername as read
+    void markConversationRead(const std::string& withUsername);
     
     void addNotification(User* user, const std::string& message);
     std::vector<std::string> getNotifications() const;
     void clearNotifications();
 
     User* getCurrentUser() const { return currentUser; }
-    const std::vector<User*>& getUsers() const { return users; }
-    const std::vector<Post*>& getPosts() const { return posts; }
-    const std::map<std::string, std::vector<std::pair<std::string, std::string>>>& getConversations() const { return conversations; }
+    const std::vector<User*>& getUsers() const { return users.getUsers(); }
+    const UserDirectory& getDirectory() const { return users; }
+    const StartupReport& getStartupReport() const { return startupReport; }
+    const std::vector<Post*>& getPosts() const { return posts.getPosts(); }
 };
 
 #endif
@@ -0,0 +1,60 @@
+#ifndef FEEDSERVICE_H
+#define FEEDSERVICE_H
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "UserId.h"
+
+class Post;
+class User;
+class UserDirectory;
+
+// Position in a feed: the (epoch, id) of the last post already returned.
+// A default-constructed cursor starts at the newest post.
+struct FeedCursor {
+    std::int64_t epoch = std::numeric_limits<std::int64_t>::max();
+    int postId = std::numeric_limits<int>::max();
+
+    bool atStart() const {
+        return epoch == std::numeric_limits<std::int64_t>::max() &&
+               postId == std::numeric_limits<int>::max();
+    }
+    // True if a post at (epoch, postId) comes after this cursor, i.e. is older
+    bool precedes(std::int64_t otherEpoch, int otherId) const {
+        return otherEpoch != epoch ? otherEpoch < epoch : otherId < postId;
+    }
+};
+
+struct FeedPage {
+    std::vector<Post*> posts;  // newest first
+    FeedCursor next;           // pass back to fetch the following page
+    bool hasMore = false;
+};
+
+// Builds a user's timeline from their own posts and their friends' posts.
+// Each author's post list is already chronological (User::addPost), so a page
+// is a k-way merge over the authors' lists: O(friends + page * log(friends))
+// instead of a scan over every post in the system.
+class FeedService {
+private:
+    const UserDirectory& directory;
+
+public:
+    explicit FeedService(const UserDirectory& directory) : directory(directory) {}
+
+    // The viewer plus every friend who is not blocked in either direction
+    std::vector<const User*> collectAuthors(const User& viewer) const;
+
+    // Whether viewer may see post in their feed: privacy, blocking in either
+    // direction, and restricted friends (who only see public posts)
+    static bool isVisible(const Post& post, const User& viewer);
+
+    FeedPage getFeed(const User& viewer, const FeedCursor& cursor = FeedCursor(),
+                     std::size_t pageSize = 20) const;
+    // Same merge restricted to the given authors
+    FeedPage mergeAuthors(const User& viewer, const std::vector<const User*>& authors,
+                          const FeedCursor& cursor, std::size_t pageSize) const;
+};
+
+#endif
@@ -10,15 +10,20 @@
 #include "Post.h"
 #include "Comment.h"
 #include "Conversation.h"
+#include "UserDirectory.h"
 #include "Exceptions.h"
+#include "TextStorage.h"
 
+// Static load/save helpers over the text storage backend (see TextStorage for
+// the file formats). Every function throws FileOperationException on failure.
 class FileManager {
 public:
+    static const std::string DATA_DIR;
     static const std::string USERS_FILE;
     static const std::string POSTS_FILE;
     static const std::string FRIENDS_FILE;
 
-    static void loadData(std::vector<User*>& users, 
+    static void loadData(UserDirectory& users, 
                         std::vector<Post*>& posts,
                         std::map<std::string, std::vector<std::pair<std::string, std::string>>>& conversations);
 
@@ -26,10 +31,10 @@ public:
                         const std::vector<Post*>& posts,
                         const std::map<std::string, std::vector<std::pair<std::string, std::string>>>& conversations);
 
-    static void loadUsers(std::vector<User*>& users);
-    static void loadPosts(std::vector<User*>& users, std::vector<Post*>& posts);
+    static void loadUsers(UserDirectory& users);
+    static void loadPosts(const UserDirectory& users, std::vector<Post*>& posts);
     static void loadConversations(std::map<std::string, std::vector<std::pair<std::string, std::string>>>& conversations);
-    static void loadFriendships(std::vector<User*>& users);
+    static void loadFriendships(const UserDirectory& users);
 
     static void saveUsers(const std::vector<User*>& users);
     static void savePosts(const std::vector<Post*>& posts);
@@ -37,8 +42,9 @@ public:
     static void saveFriendships(const std::vector<User*>& users);
 
 private:
-    static std::vector<std::string> readLines(const std::string& filename);
-    static void writeLines(const std::string& filename, const std::vector<std::string>& lines);
+    static void save(const std::vector<User*>* users, const std::vector<Post*>* posts,
+                     const std::map<std::string, std::vector<std::pair<std::string, std::string>>>* conversations,
+                     unsigned entities);
 };
 
 #endif
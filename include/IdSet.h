@@ -0,0 +1,53 @@
+#ifndef IDSET_H
+#define IDSET_H
+
+#include <vector>
+#include <algorithm>
+#include "UserId.h"
+
+// Sorted, duplicate-free vector of ids. Membership is a binary search and
+// two sets can be intersected with a linear (SIMD where available) merge.
+class IdSet {
+private:
+    std::vector<UserId> ids;
+
+public:
+    using const_iterator = std::vector<UserId>::const_iterator;
+
+    IdSet() = default;
+
+    bool insert(UserId id) {
+        auto it = std::lower_bound(ids.begin(), ids.end(), id);
+        if (it != ids.end() && *it == id) return false;
+        ids.insert(it, id);
+        return true;
+    }
+
+    bool erase(UserId id) {
+        auto it = std::lower_bound(ids.begin(), ids.end(), id);
+        if (it == ids.end() || *it != id) return false;
+        ids.erase(it);
+        return true;
+    }
+
+    bool contains(UserId id) const {
+        return std::binary_search(ids.begin(), ids.end(), id);
+    }
+
+    void clear() { ids.clear(); }
+    void reserve(std::size_t n) { ids.reserve(n); }
+    std::size_t size() const { return ids.size(); }
+    bool empty() const { return ids.empty(); }
+    UserId operator[](std::size_t i) const { return ids[i]; }
+    const std::vector<UserId>& values() const { return ids; }
+    const_iterator begin() const { return ids.begin(); }
+    const_iterator end() const { return ids.end(); }
+
+    // Appends a ∩ b to out (if given) in ascending order; returns its size
+    static std::size_t intersect(const IdSet& a, const IdSet& b, std::vector<UserId>* out = nullptr);
+    static std::size_t intersect(const UserId* a, std::size_t aSize,
+                                 const UserId* b, std::size_t bSize,
+                                 std::vector<UserId>* out);
+};
+
+#endif
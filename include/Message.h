@@ -2,6 +2,7 @@
 
 #include <string>
 #include <vector>
+#include "ObjectPool.h"
 
 class User;
 
@@ -15,6 +16,10 @@ public:
     Message(User* sender, const std::string& content, const std::string& timestamp)
         : sender(sender), content(content), timestamp(timestamp) {}
 
+    // Allocated from ObjectPool<Message>
+    static void* operator new(std::size_t size) { return ObjectPool<Message>::shared().allocate(size); }
+    static void operator delete(void* p, std::size_t size) { ObjectPool<Message>::shared().deallocate(p, size); }
+
     User* getSender() const { return sender; }
     const std::string& getContent() const { return content; }
     const std::string& getTimestamp() const { return timestamp; }
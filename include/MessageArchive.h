@@ -0,0 +1,159 @@
+#ifndef MESSAGEARCHIVE_H
+#define MESSAGEARCHIVE_H
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "StorageEngine.h"
+
+// Append-only message history, split into BUCKET_COUNT files by a hash of
+// the two participants' usernames:
+//   <dir>/<bucket>.log   from|to|timestamp|text\n   (WriteAheadLog escaping)
+// A conversation always lands in the same bucket, and each run of its
+// consecutive records there is a segment. <dir>/index lists every
+// conversation's segments (offset, length, count), how many bytes of each
+// bucket they cover, and each conversation's inbox summary:
+//   B|bucket|bytes
+//   C|userA|userB|lastEpoch|lastFrom|preview|readA|readB
+//   S|userA|userB|offset|length|count
+// Sending a message is one append to its bucket. Opening reads the index and
+// scans only what was appended to each bucket after it was written; reading a
+// conversation reads only its segments, so the history is never resident as
+// a whole. The index is rewritten at checkpoints (encodeIndex()).
+//
+// Every user also has an inbox: their conversations with the last message's
+// time, sender and a preview, and how many messages they have not read. It
+// is kept up to date on every append, so listing a user's chats costs
+// O(their conversations) however many conversations there are in total.
+//
+// The archive exists once its index does: an import appends to fresh
+// buckets and writes the index last, so an interrupted one starts over.
+class MessageArchive {
+public:
+    static constexpr std::size_t BUCKET_COUNT = 64;
+    static constexpr std::size_t PREVIEW_LENGTH = 60;  // bytes
+
+    struct Segment {
+        std::uint64_t offset;
+        std::uint64_t length;
+        std::uint32_t count;
+    };
+
+    struct InboxEntry {
+        std::string peer;
+        std::int64_t lastEpoch;
+        std::string lastFrom;
+        std::string preview;
+        std::size_t messages;
+        std::size_t unread;
+    };
+
+private:
+    struct Conversation {
+        std::string low;   // usernames, low < high
+        std::string high;
+        std::uint32_t bucket = 0;
+        std::vector<Segment> segments;
+        std::size_t messages = 0;
+        std::int64_t lastEpoch = 0;
+        std::string lastFrom;
+        std::string preview;
+        std::size_t lowRead = 0;   // messages each participant has seen
+        std::size_t highRead = 0;
+
+        std::size_t& readBy(std::string_view user) { return user == low ? lowRead : highRead; }
+        std::size_t readBy(std::string_view user) const { return user == low ? lowRead : highRead; }
+        // Saturates: a bucket indexed afresh can hold fewer messages than were read
+        std::size_t unreadBy(std::string_view user) const {
+            return messages > readBy(user) ? messages - readBy(user) : 0;
+        }
+    };
+
+    std::string directory;
+    std::unordered_map<std::string, Conversation> conversations;  // by pairKey
+    // Username -> their conversations (map nodes never move)
+    std::unordered_map<std::string, std::vector<const Conversation*>> inboxes;
+    std::array<std::uint64_t, BUCKET_COUNT> bucketBytes{};
+    std::array<std::FILE*, BUCKET_COUNT> files{};
+    std::array<bool, BUCKET_COUNT> unsynced{};  // appended to since the last sync()
+    // pairKey -> encoded stored record -> copies not yet matched by a replay
+    std::unordered_map<std::string, std::unordered_map<std::string, std::size_t>> replayMatches;
+    std::size_t messages = 0;
+    bool exists = false;
+    bool indexStale = false;
+
+    static std::string pairKey(std::string_view a, std::string_view b);
+    std::string bucketPath(std::size_t bucket) const;
+    std::string indexPath() const { return directory + "/index"; }
+    Conversation& conversation(std::string_view a, std::string_view b);
+    // Extends the conversation's last segment with the record at offset, or
+    // starts a new one, and makes the message its latest
+    void addRecord(std::size_t bucket, const std::string& from, const std::string& to,
+                   const std::string& timestamp, const std::string& text,
+                   std::uint64_t offset, std::uint64_t length);
+    bool readIndex();
+    // Indexes the complete records of bucket from offset on and drops a torn tail
+    void scanBucket(std::size_t bucket, std::uint64_t offset);
+    void closeFiles();
+
+public:
+    explicit MessageArchive(std::string directory);
+    ~MessageArchive();
+
+    MessageArchive(const MessageArchive&) = delete;
+    MessageArchive& operator=(const MessageArchive&) = delete;
+
+    // Loads the index and catches up on later appends; false if there is no
+    // archive yet
+    bool open();
+    // Starts an empty archive, discarding buckets left by an interrupted import
+    void create();
+    bool isOpen() const { return exists; }
+
+    // Buffered; call sync() to make the appends durable
+    void append(std::string_view from, std::string_view to, std::string_view timestamp, std::string_view text);
+    // Flushes the buckets appended to since the last call; after a single
+    // append that is one fsync, not one per open bucket
+    void sync();
+
+    // Calls visit with every message between a and b in send order, reading
+    // only their segments; returns the number of messages
+    std::size_t read(std::string_view a, std::string_view b,
+                     const std::function<void(const StorageEngine::MessageRow&)>& visit) const;
+    std::size_t messageCount(std::string_view a, std::string_view b) const;
+    // Appends a message replayed from a log written before the archive existed,
+    // unless the archive already stores it. Replayed records are matched
+    // exactly against the conversation's stored ones, each stored copy
+    // absorbing one replayed copy, so a log the archive has absorbed can be
+    // replayed again while a message it never absorbed is appended however
+    // old it is. Returns whether the message was appended.
+    bool appendUnlessStored(std::string_view from, std::string_view to,
+                            std::string_view timestamp, std::string_view text);
+    // Drops the stored records appendUnlessStored() read for matching
+    void endReplay() { replayMatches.clear(); }
+    const std::vector<Segment>& segmentsOf(std::string_view a, std::string_view b) const;
+    // username's conversations, most recently active first; limit == 0 returns all
+    std::vector<InboxEntry> inboxOf(const std::string& username, std::size_t limit = 0) const;
+    std::size_t unreadCount(const std::string& username) const;
+    // Marks the conversation read up to its latest message; false if it
+    // already was
+    bool markRead(const std::string& username, const std::string& peer);
+    static std::string previewOf(std::string_view text);
+
+    // The index as of now, to be written with StorageEngine::commit
+    StorageEngine::FileImage encodeIndex();
+    // Writes the index now, e.g. to finish an import
+    bool writeIndex();
+    bool hasUnindexedChanges() const { return indexStale; }
+
+    std::size_t conversationCount() const { return conversations.size(); }
+    std::size_t size() const { return messages; }
+    const std::string& getDirectory() const { return directory; }
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef MUTUALFRIENDS_H
+#define MUTUALFRIENDS_H
+
+#include <vector>
+#include "UserId.h"
+
+class User;
+class UserDirectory;
+
+struct FriendSuggestion {
+    User* user;
+    std::size_t mutualCount;
+};
+
+// Mutual-friend queries and "people you may know" ranking over the friend graph.
+// All work is done on sorted IdSets; ids are turned back into User* through the directory.
+class MutualFriends {
+private:
+    const UserDirectory& directory;
+
+public:
+    // Below this many friend-of-friend edges the aggregation stays on the calling thread
+    static constexpr std::size_t PARALLEL_EDGE_THRESHOLD = 50000;
+
+    explicit MutualFriends(const UserDirectory& directory) : directory(directory) {}
+
+    // Friends of both users, excluding anyone either side has restricted
+    static std::vector<UserId> mutualFriendIds(const User& a, const User& b);
+
+    std::vector<User*> mutualFriends(const User& a, const User& b) const;
+    std::size_t countMutualFriends(const User& a, const User& b) const;
+
+    // Top-k non-friends ranked by number of mutual friends (ties broken by id).
+    // threads == 0 goes parallel on hardware_concurrency() cores only for large graphs.
+    std::vector<FriendSuggestion> suggestFriends(const User& user, std::size_t k,
+                                                 unsigned threads = 0) const;
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#if defined(__SANITIZE_ADDRESS__)
+#define OBJECTPOOL_BYPASS 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define OBJECTPOOL_BYPASS 1
+#endif
+#endif
+
+// Fixed-size slot allocator for one type. Slots are carved out of slabs that
+// double in size (up to MAX_SLAB slots), so loading a large data set costs a
+// few big allocations, objects of the type sit next to each other, and a
+// slot's address never changes while it is live. Freed slots are reused
+// before the pool grows; slabs are kept until the pool is destroyed.
+//
+// Types opt in with class-level operator new/delete that call shared().
+// Requests of another size (a derived class) go to the global heap. Under
+// AddressSanitizer every request does, so use-after-free is still caught.
+template <typename T>
+class ObjectPool {
+public:
+    static constexpr std::size_t FIRST_SLAB = 64;
+    static constexpr std::size_t MAX_SLAB = 64 * 1024;
+#ifdef OBJECTPOOL_BYPASS
+    static constexpr bool ENABLED = false;
+#else
+    static constexpr bool ENABLED = true;
+#endif
+
+private:
+    union Slot {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<Slot[]>> slabs;
+    std::size_t slotCount = 0;
+    std::size_t live = 0;
+    Slot* freeList = nullptr;
+
+    void grow() {
+        std::size_t size = slabs.empty() ? FIRST_SLAB : std::min(slotCount, MAX_SLAB);
+        slabs.emplace_back(new Slot[size]);
+        Slot* slab = slabs.back().get();
+        for (std::size_t i = size; i-- > 0;) {
+            slab[i].next = freeList;
+            freeList = &slab[i];
+        }
+        slotCount += size;
+    }
+
+public:
+    ObjectPool() = default;
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    void* allocate(std::size_t size = sizeof(T)) {
+        if (!ENABLED || size != sizeof(T)) return ::operator new(size);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!freeList) grow();
+        Slot* slot = freeList;
+        freeList = slot->next;
+        ++live;
+        return slot;
+    }
+
+    void deallocate(void* p, std::size_t size = sizeof(T)) {
+        if (!p) return;
+        if (!ENABLED || size != sizeof(T)) {
+            ::operator delete(p);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        Slot* slot = static_cast<Slot*>(p);
+        slot->next = freeList;
+        freeList = slot;
+        --live;
+    }
+
+    // Locked, since other threads may be allocating
+    std::size_t liveCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return live;
+    }
+    std::size_t capacity() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return slotCount;
+    }
+    std::size_t slabCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return slabs.size();
+    }
+
+    // The pool behind T's operator new. It is never destroyed, so objects
+    // freed during static destruction still have somewhere to go.
+    static ObjectPool& shared() {
+        static ObjectPool* pool = new ObjectPool();
+        return *pool;
+    }
+};
+
+#endif
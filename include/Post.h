@@ -4,11 +4,17 @@
 #include <vector>
 #include <algorithm>
 #include <map>
+#include <cstdint>
 #include "IReactable.h"
 #include "Comment.h"
+#include "UserId.h"
+#include "IdSet.h"
 #include "Exceptions.h"
+#include "Versioned.h"
+#include "ObjectPool.h"
 
 class User;  // Forward declaration
+class PostStore;
 
 enum class PostPrivacy {
     PUBLIC,
@@ -16,53 +22,62 @@ enum class PostPrivacy {
     PRIVATE
 };
 
-class Post {
+// Versioned covers what is persisted: privacy and likes
+class Post : public Versioned {
 private:
     static inline int nextId = 0;
     int id;
     User* user;
     std::string content;
     std::string timestamp;
-    std::vector<std::string> likes;
+    std::int64_t epoch;  // timestamp parsed once, for ordering
+    IdSet likes;
     std::vector<Comment*> comments;
     std::vector<User*> taggedUsers;
     PostPrivacy privacy;
+    PostStore* store = nullptr;  // set while a PostStore owns this post
+
+    friend class PostStore;
 
 public:
     Post(User* user, const std::string& content, const std::string& timestamp, PostPrivacy privacy = PostPrivacy::PUBLIC);
+    // Restores a persisted post under its saved id; later posts are numbered after it
+    Post(int id, User* user, const std::string& content, const std::string& timestamp, PostPrivacy privacy = PostPrivacy::PUBLIC);
     ~Post();
 
+    // Allocated from ObjectPool<Post>
+    static void* operator new(std::size_t size) { return ObjectPool<Post>::shared().allocate(size); }
+    static void operator delete(void* p, std::size_t size) { ObjectPool<Post>::shared().deallocate(p, size); }
+
     int getId() const { return id; }
     User* getUser() const { return user; }
     const std::string& getContent() const { return content; }
     const std::string& getTimestamp() const { return timestamp; }
+    std::int64_t getEpoch() const { return epoch; }
+    // Chronological order: by timestamp, then by id for posts created in the same second
+    static bool olderThan(const Post* a, const Post* b) {
+        return a->epoch != b->epoch ? a->epoch < b->epoch : a->id < b->id;
+    }
     PostPrivacy getPrivacy() const { return privacy; }
     std::string getAuthorUsername() const;
     
-    const std::vector<std::string>& getLikes() const { return likes; }
+    const IdSet& getLikeIds() const { return likes; }
+    std::vector<std::string> getLikes() const;
+    std::size_t getLikeCount() const { return likes.size(); }
     const std::vector<Comment*>& getComments() const { return comments; }
     const std::vector<User*>& getTaggedUsers() const { return taggedUsers; }
     
-    void addLike(const std::string& username) {
-        if (std::find(likes.begin(), likes.end(), username) == likes.end()) {
-            likes.push_back(username);
-        }
-    }
-    
-    void removeLike(const std::string& username) {
-        auto it = std::find(likes.begin(), likes.end(), username);
-        if (it != likes.end()) {
-            likes.erase(it);
-        }
-    }
-    
-    bool hasLiked(const std::string& username) const {
-        return std::find(likes.begin(), likes.end(), username) != likes.end();
-    }
+    void addLike(UserId userId) { if (likes.insert(userId)) touch(); }
+    void removeLike(UserId userId) { if (likes.erase(userId)) touch(); }
+    bool hasLiked(UserId userId) const { return likes.contains(userId); }
+
+    void addLike(const std::string& username);
+    void removeLike(const std::string& username);
+    bool hasLiked(const std::string& username) const;
     
     Comment* addComment(User* author, const std::string& content);
     void tagUser(User* user);
-    void setPrivacy(PostPrivacy newPrivacy) { privacy = newPrivacy; }
+    void setPrivacy(PostPrivacy newPrivacy);
     bool isUserTagged(const User* user) const {
         return std::find(taggedUsers.begin(), taggedUsers.end(), user) != taggedUsers.end();
     }
@@ -0,0 +1,60 @@
+#ifndef POSTSEARCHINDEX_H
+#define POSTSEARCHINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Post;
+
+// Incrementally maintained inverted index over post content.
+//
+// Text is split into case-folded word tokens; hashtags such as "#cpp" are
+// indexed both as "#cpp" and as the bare word "cpp". Queries support:
+//   word1 word2        - posts containing both (AND)
+//   word1 OR word2     - posts containing either
+//   "exact phrase"     - consecutive words, in order
+// Results are ranked by tf-idf, newest first on ties.
+class PostSearchIndex {
+public:
+    struct Token {
+        std::string term;
+        std::uint32_t position;
+    };
+
+    static std::vector<Token> tokenize(const std::string& text);
+
+    void addPost(const Post* post);
+    void removePost(const Post* post);
+    void clear();
+
+    // Ranked post ids; limit == 0 means no limit
+    std::vector<int> search(const std::string& query, std::size_t limit = 0) const;
+
+    std::size_t documentCount() const { return documentLengths.size(); }
+    std::size_t termCount() const { return postings.size(); }
+
+private:
+    struct Posting {
+        int postId;
+        std::vector<std::uint32_t> positions;
+    };
+
+    // One AND-clause of a query: loose terms plus any quoted phrases
+    struct Clause {
+        std::vector<std::string> terms;
+        std::vector<std::vector<std::string>> phrases;
+    };
+
+    std::unordered_map<std::string, std::vector<Posting>> postings; // sorted by postId
+    std::unordered_map<int, std::uint32_t> documentLengths;
+
+    static std::vector<Clause> parseQuery(const std::string& query);
+    const std::vector<Posting>* findPostings(const std::string& term) const;
+    static const Posting* findPosting(const std::vector<Posting>& list, int postId);
+    bool matchesPhrase(int postId, const std::vector<std::string>& phrase) const;
+    double idf(const std::vector<Posting>& list) const;
+};
+
+#endif
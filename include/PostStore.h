@@ -0,0 +1,94 @@
+#ifndef POSTSTORE_H
+#define POSTSTORE_H
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "UserId.h"
+
+class Post;
+enum class PostPrivacy;
+
+// Owner of every live post. Posts are kept in creation order plus a dense
+// id -> Post slot table. Post ids come from Post::nextId, so a vector indexed
+// by id gives O(1) lookup that stays correct after deletions (removed slots
+// are simply cleared). Everything else (users' post lists, indexes, caches)
+// holds non-owning pointers that are valid while the post is stored.
+//
+// The fields that feeds and filters test (author, time, privacy) are also
+// kept as columns indexed by id, so scans and visibility checks read a few
+// tight arrays instead of dereferencing every Post. Author and time never
+// change; a stored post reports privacy changes back here (Post::setPrivacy).
+//
+// Ids come from files and logs too, so the table only grows to a few slots
+// per stored post: an id far beyond that (a corrupt or hand-edited one) is
+// kept in a side map instead of allocating columns up to it.
+class PostStore {
+public:
+    static constexpr std::size_t MIN_DENSE_SLOTS = 1024;
+    static constexpr std::size_t DENSE_SLOTS_PER_POST = 4;
+
+private:
+    std::vector<Post*> posts;
+    std::vector<std::unique_ptr<Post>> slots;  // owning
+    std::unordered_map<int, std::unique_ptr<Post>> sparse;  // owning; every id >= slots.size()
+    // Columns by id; empty slots (and posts without an author) have author
+    // INVALID_USER_ID and are skipped by scans
+    std::vector<UserId> authorIds;
+    std::vector<std::int64_t> epochs;
+    std::vector<std::uint8_t> privacies;
+
+    friend class Post;
+    void reindexPrivacy(const Post* post);
+    // Stores a post whose id is inside the table
+    void place(std::unique_ptr<Post> post);
+    Post* findSparse(int postId) const;
+    bool isDense(int postId) const {
+        return postId >= 0 && static_cast<std::size_t>(postId) < slots.size();
+    }
+
+public:
+    PostStore() = default;
+    ~PostStore();
+
+    PostStore(const PostStore&) = delete;
+    PostStore& operator=(const PostStore&) = delete;
+
+    // Takes ownership and returns the stored post; returns nullptr (and
+    // destroys the post) for null posts or ids that are already stored
+    Post* addPost(std::unique_ptr<Post> post);
+    // Unlinks the post and hands it back; null if it is not stored here
+    std::unique_ptr<Post> removePost(Post* post);
+    // Destroys every stored post
+    void clear();
+
+    Post* findById(int postId) const {
+        if (postId < 0) return nullptr;
+        if (isDense(postId)) return slots[postId].get();
+        return sparse.empty() ? nullptr : findSparse(postId);
+    }
+    bool contains(int postId) const { return findById(postId) != nullptr; }
+
+    // Column reads; INVALID_USER_ID / 0 / PUBLIC for ids that are not stored
+    UserId authorOf(int postId) const;
+    std::int64_t epochOf(int postId) const;
+    PostPrivacy privacyOf(int postId) const;
+
+    // Ids of posts with fromEpoch <= epoch < toEpoch whose privacy is at most
+    // widest (PUBLIC < FRIENDS_ONLY < PRIVATE), in id order
+    std::vector<int> idsBetween(std::int64_t fromEpoch, std::int64_t toEpoch, PostPrivacy widest) const;
+    // Same posts, newest first
+    std::vector<Post*> postsBetween(std::int64_t fromEpoch, std::int64_t toEpoch, PostPrivacy widest) const;
+
+    const std::vector<Post*>& getPosts() const { return posts; }
+    std::size_t size() const { return posts.size(); }
+    // Slots in the id table (posts outside it are in the side map)
+    std::size_t tableSize() const { return slots.size(); }
+    bool empty() const { return posts.empty(); }
+
+    std::vector<Post*>::const_iterator begin() const { return posts.begin(); }
+    std::vector<Post*>::const_iterator end() const { return posts.end(); }
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef STARTUPLOADER_H
+#define STARTUPLOADER_H
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "DelimitedReader.h"
+
+// Wall-clock time per startup phase, printed as a report once loading is done
+class StartupReport {
+public:
+    struct Phase {
+        std::string name;
+        double milliseconds;
+    };
+
+private:
+    std::vector<Phase> phases;
+
+public:
+    // Runs fn, records how long it took under name and returns its result
+    template <typename Fn>
+    auto time(const std::string& name, Fn&& fn) -> decltype(fn()) {
+        auto start = std::chrono::steady_clock::now();
+        auto record = [&] {
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            phases.push_back({name, elapsed.count()});
+        };
+        if constexpr (std::is_void_v<decltype(fn())>) {
+            fn();
+            record();
+        } else {
+            auto result = fn();
+            record();
+            return result;
+        }
+    }
+
+    void clear() { phases.clear(); }
+    const std::vector<Phase>& getPhases() const { return phases; }
+    double totalMilliseconds() const;
+    void print() const;
+};
+
+// Parses several '|'-delimited files at once. Each file is split into
+// line-aligned byte ranges, and all ranges of all files are handed to a
+// fixed set of worker threads. Rows are string_views into the mapped files,
+// so they stay valid for the loader's lifetime; they come back in file order
+// so the (serial) link phase sees exactly what a sequential read would.
+class StartupLoader {
+public:
+    static constexpr std::size_t MAX_FIELDS = 5;
+    static constexpr std::size_t DEFAULT_CHUNK_BYTES = 1 << 20;
+    using Row = std::array<std::string_view, MAX_FIELDS>;
+
+private:
+    struct File {
+        std::string path;
+        std::size_t fields;
+        std::unique_ptr<DelimitedReader> source;  // owns the mapping
+        bool opened = false;
+        std::vector<Row> rows;
+    };
+
+    unsigned threads;
+    std::size_t chunkBytes;
+    std::vector<File> files;
+
+public:
+    explicit StartupLoader(unsigned threads = 0, std::size_t chunkBytes = DEFAULT_CHUNK_BYTES);
+
+    // Registers a file; lines with fewer than fields fields are skipped, and
+    // the last field keeps the rest of the line. Returns the file's index.
+    std::size_t addFile(const std::string& path, std::size_t fields);
+
+    // Maps every registered file and parses them concurrently
+    void parseAll();
+
+    bool opened(std::size_t file) const { return files[file].opened; }
+    const std::vector<Row>& rows(std::size_t file) const { return files[file].rows; }
+    const std::string& path(std::size_t file) const { return files[file].path; }
+};
+
+#endif
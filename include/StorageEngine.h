@@ -0,0 +1,125 @@
+#ifndef STORAGEENGINE_H
+#define STORAGEENGINE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Post.h"
+
+class User;
+class StartupReport;
+
+// Common interface of the persistence backends. Every backend stores the same
+// schema, one record type per entity:
+//
+//   user        username, email, password, gender, flags
+//   post        id, author, privacy, timestamp, content
+//   like        post id, username
+//   friendship  username, username (each pair once)
+//   message     from, to, timestamp, text
+//
+// Loading streams records into a Sink in dependency order (users, posts,
+// likes, friendships, messages), so a sink can resolve names as it goes.
+// Saving is split in two: encode() serializes the live model (read through a
+// Dataset) into whole-file images, and commit() writes them atomically. Only
+// encode() touches the model, so commit() can run on a background thread.
+class StorageEngine {
+public:
+    // Bit per entity, used to load or save a subset
+    enum Entity : unsigned {
+        USERS = 1u << 0,
+        POSTS = 1u << 1,
+        FRIENDSHIPS = 1u << 2,
+        LIKES = 1u << 3,
+        MESSAGES = 1u << 4,
+        ALL = USERS | POSTS | FRIENDSHIPS | LIKES | MESSAGES
+    };
+
+    enum UserFlags : std::uint32_t {
+        USER_BOT = 1u << 0,
+        USER_PUBLIC = 1u << 1
+    };
+
+    // Record views handed to a Sink; they are only valid during the call
+    struct UserRow {
+        std::string_view username;
+        std::string_view email;
+        std::string_view password;
+        std::string_view gender;
+        std::uint32_t flags = 0;
+    };
+
+    struct PostRow {
+        int id = -1;  // -1 if the stored id was unusable
+        std::string_view author;
+        PostPrivacy privacy = PostPrivacy::PUBLIC;
+        std::string_view timestamp;
+        std::string_view content;
+    };
+
+    struct LikeRow {
+        int postId;
+        std::string_view username;
+    };
+
+    struct FriendshipRow {
+        std::string_view user1;
+        std::string_view user2;
+    };
+
+    struct MessageRow {
+        std::string_view from;
+        std::string_view to;
+        std::string_view timestamp;
+        std::string_view text;
+    };
+
+    // Receives loaded records; entities a sink does not handle are dropped
+    class Sink {
+    public:
+        virtual ~Sink() = default;
+        virtual void user(const UserRow&) {}
+        virtual void post(const PostRow&) {}
+        virtual void like(const LikeRow&) {}
+        virtual void friendship(const FriendshipRow&) {}
+        virtual void message(const MessageRow&) {}
+    };
+
+    // What to save. Friendships are read from users and likes from posts.
+    struct Dataset {
+        const std::vector<User*>* users = nullptr;
+        const std::vector<Post*>* posts = nullptr;
+        const std::vector<MessageRow>* messages = nullptr;
+        unsigned entities = ALL;
+    };
+
+    // The complete new contents of one file
+    struct FileImage {
+        std::string path;
+        std::string bytes;
+    };
+    using FileImages = std::vector<FileImage>;
+
+    virtual ~StorageEngine() = default;
+
+    virtual const char* name() const = 0;
+    // False if nothing usable is stored; phases are timed into report if given
+    virtual bool load(Sink& sink, unsigned entities = ALL, StartupReport* report = nullptr) = 0;
+    // Appends the files that store data to images; false if data is incomplete
+    virtual bool encode(const Dataset& data, FileImages& images) = 0;
+
+    // Replaces each file through AtomicFile; false if any write failed
+    static bool commit(const FileImages& images);
+    bool save(const Dataset& data);
+
+    // Conversations are keyed "<a>_<b>" with the names in order; chatPeer
+    // recovers the other participant from a key and one sender
+    static std::string chatKey(const std::string& user1, const std::string& user2);
+    static std::string_view chatPeer(const std::string& key, const std::string& sender);
+    static PostPrivacy toPrivacy(std::uint32_t value);
+    // UserFlags of a user, as every backend stores them
+    static std::uint32_t userFlags(const User& user);
+};
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef STRINGINTERNER_H
+#define STRINGINTERNER_H
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Maps strings to dense 32-bit ids and back. Ids are never reused, and the
+// string for an id stays at a stable address for the life of the interner.
+class StringInterner {
+private:
+    std::unordered_map<std::string, std::uint32_t> ids;
+    std::deque<std::string> strings;
+    mutable std::mutex mutex;
+
+public:
+    static constexpr std::uint32_t npos = UINT32_MAX;
+
+    // Process-wide interner shared by every User and Post
+    static StringInterner& usernames();
+
+    std::uint32_t intern(const std::string& value);
+    std::uint32_t find(const std::string& value) const;
+    // The reference stays valid for the life of the interner, but rename()
+    // overwrites the string in place: copy it if a rename may run concurrently
+    const std::string& str(std::uint32_t id) const;
+    // Points an existing id at a new string (used when a user is renamed).
+    // Throws std::invalid_argument if newValue is already interned under
+    // another id, since that id would then name a string that resolves elsewhere.
+    void rename(std::uint32_t id, const std::string& newValue);
+    std::size_t size() const;
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef TEXTSTORAGE_H
+#define TEXTSTORAGE_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "StorageEngine.h"
+
+// Human-readable backend: one '|'-delimited file per entity in a directory.
+//
+//   users.txt     username|email|password|gender|flags
+//   posts.txt     id|author|privacy|timestamp|content
+//   likes.txt     postId|username
+//   friends.txt   username|username
+//   messages.txt  from|to|timestamp|text
+//
+// Each file starts with a "#schema 2" line. '\\', '|', '\n' and '\r' inside a
+// field are written as "\\\\", "\\p", "\\n" and "\\r", so a raw '|' is always a
+// delimiter. Files without the header line are read in the formats written
+// before the schema was unified (users as email|username or username|email,
+// posts as id|author|content|timestamp or author|content|timestamp|privacy,
+// messages as from|to|text|timestamp) and are not unescaped.
+//
+// All requested files are parsed concurrently by a StartupLoader.
+class TextStorage : public StorageEngine {
+public:
+    static constexpr int SCHEMA_VERSION = 2;
+
+    enum File { USERS_FILE, POSTS_FILE, FRIENDS_FILE, LIKES_FILE, MESSAGES_FILE, FILE_COUNT };
+    using FileSizes = std::array<std::uint64_t, FILE_COUNT>;
+    using FileHashes = std::array<std::uint64_t, FILE_COUNT>;
+
+private:
+    std::array<std::string, FILE_COUNT> paths;
+    // Size and hash of the last image encoded for each file, which it has once committed
+    FileSizes encodedSizes{};
+    FileHashes encodedHashes{};
+    std::array<bool, FILE_COUNT> encoded{};
+
+public:
+    explicit TextStorage(const std::string& directory);
+
+    const char* name() const override { return "text"; }
+    bool load(Sink& sink, unsigned entities = ALL, StartupReport* report = nullptr) override;
+    bool encode(const Dataset& data, FileImages& images) override;
+
+    const std::string& path(File file) const { return paths[file]; }
+    // Current size of every file, 0 for missing ones
+    FileSizes fileSizes() const;
+    // Sizes the files will have once every image encoded so far is committed;
+    // files never encoded here keep their current size
+    FileSizes expectedSizes() const;
+    // Content hash of every file (hashOf an empty file for missing ones);
+    // reads them all, so check the sizes first
+    FileHashes fileHashes() const;
+    // Hashes to go with expectedSizes()
+    FileHashes expectedHashes() const;
+    static std::uint64_t hashOf(std::string_view bytes);
+
+    static void escape(std::string_view field, std::string& out);
+    // Returns field, or its decoded form stored in scratch if it has escapes
+    static std::string_view unescape(std::string_view field, std::string& scratch);
+    // Schema version from the file's first line; 1 for legacy or missing files
+    static int schemaOf(const std::string& path);
+};
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef TIMELINECACHE_H
+#define TIMELINECACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "UserId.h"
+#include "FeedService.h"
+
+class Post;
+class PostStore;
+
+// Hybrid fan-out feed cache.
+//
+// On write, a post by an ordinary author is pushed into a bounded ring buffer
+// for the author and each friend that already has a cached timeline. Authors
+// with more than fanoutThreshold friends, bots (User::isBot, such as the
+// default bots every user befriends) and anyone marked hot are skipped on write; their posts are merged in
+// at read time through FeedService, so one popular post costs O(1) to write.
+//
+// Rings hold (epoch, post id) pairs and are resolved through the PostStore on
+// read, so deleted posts simply drop out. A timeline is built lazily on first
+// read and discarded whenever it can no longer be trusted (friendship changes,
+// back-dated inserts).
+class TimelineCache {
+public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 200;
+    static constexpr std::size_t DEFAULT_FANOUT_THRESHOLD = 500;
+
+private:
+    struct Entry {
+        std::int64_t epoch;
+        int postId;
+    };
+
+    // Fixed-capacity ring of the newest posts, oldest at head
+    struct Timeline {
+        std::vector<Entry> slots;
+        std::size_t head = 0;
+        std::size_t count = 0;
+        // True while nothing has been evicted, i.e. the ring holds every cold post
+        bool complete = true;
+
+        // i = 0 is the newest entry
+        const Entry& newest(std::size_t i) const {
+            return slots[(head + count - 1 - i) % slots.size()];
+        }
+        void push(const Entry& entry);
+    };
+
+    const UserDirectory& directory;
+    const PostStore& posts;
+    FeedService feed;
+    std::size_t capacity;
+    std::size_t fanoutThreshold;
+    std::unordered_map<UserId, Timeline> timelines;
+    // Sticky: once an author is read-merged it stays that way, so its posts are
+    // never split between rings and the read path
+    mutable std::unordered_set<UserId> hotAuthors;
+
+    Timeline& timelineFor(const User& viewer);
+
+public:
+    TimelineCache(const UserDirectory& directory, const PostStore& posts,
+                  std::size_t capacity = DEFAULT_CAPACITY,
+                  std::size_t fanoutThreshold = DEFAULT_FANOUT_THRESHOLD);
+
+    bool isHot(const User& author) const;
+    void markHot(UserId author) { hotAuthors.insert(author); }
+
+    // Fan a newly stored post out to the cached timelines of its audience
+    void onPostCreated(const Post& post);
+    // Drop a user's cached timeline; it is rebuilt on the next read
+    void invalidate(UserId user) { timelines.erase(user); }
+    void clear();
+
+    FeedPage getFeed(const User& viewer, const FeedCursor& cursor = FeedCursor(),
+                     std::size_t pageSize = 20);
+
+    bool isCached(UserId user) const { return timelines.count(user) > 0; }
+    // Posts in a user's ring (0 if it is not cached)
+    std::size_t ringSize(UserId user) const {
+        auto it = timelines.find(user);
+        return it != timelines.end() ? it->second.count : 0;
+    }
+    std::size_t cachedTimelines() const { return timelines.size(); }
+};
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <cstdint>
+#include <string>
+
+// Post and message timestamps arrive in several textual formats:
+//   "1735448416"                 (epoch seconds, from time(0))
+//   "2024-01-01 12:00:00"        (also "2024-01-01 12:00" and "2024-01-01")
+//   "Sat Dec 28 22:06:02 2024"   (std::ctime)
+// toEpoch() normalises all of them to seconds since 1970 (UTC) so they can
+// be compared and sorted as integers. Unrecognised input yields 0.
+// format() writes epoch seconds back as "YYYY-MM-DD HH:MM:SS", which
+// toEpoch() reads back to the same value.
+namespace Timestamp {
+    std::int64_t toEpoch(const std::string& timestamp);
+    std::string format(std::int64_t epoch);
+    std::int64_t daysFromCivil(std::int64_t year, unsigned month, unsigned day);
+}
+
+#endif
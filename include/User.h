@@ -6,89 +6,117 @@
 #include <algorithm>
 #include <memory>
 #include "Post.h"
+#include "UserId.h"
+#include "IdSet.h"
 #include "Exceptions.h"
+#include "Versioned.h"
 
-class User {
+class UserDirectory;
+
+// Versioned covers what is persisted: the profile fields and friendships
+class User : public Versioned {
 private:
+    UserId id;
     std::string username;
     std::string email;
     std::string password;
     std::string gender;
     bool isUserBot;
     bool isPublicProfile;
-    std::vector<std::string> friends;
-    std::vector<std::string> friendRequests;
-    std::vector<std::string> restrictedFriends;
-    std::vector<std::string> blockedUsers;
-    std::vector<Post*> posts;
+    IdSet friends;
+    IdSet friendRequests;
+    IdSet restrictedFriends;
+    IdSet blockedUsers;
+    std::vector<Post*> posts;  // not owned; see PostStore
+    UserDirectory* directory;
+
+    friend class UserDirectory;
 
 public:
     User(const std::string& username, const std::string& email,
          const std::string& password, const std::string& gender = "");
       
-    ~User() {
-        for (Post* post : posts) {
-            delete post;
-        }
-    }
+    ~User();
 
     // Getters
+    UserId getId() const { return id; }
     const std::string& getUsername() const { return username; }
     const std::string& getEmail() const { return email; }
     const std::string& getPassword() const { return password; }
     const std::string& getGender() const { return gender; }
     bool isBot() const { return isUserBot; }
     bool isPublic() const { return isPublicProfile; }
-    const std::vector<std::string>& getFriends() const { return friends; }
-    const std::vector<std::string>& getFriendRequests() const { return friendRequests; }
-    const std::vector<std::string>& getRestrictedFriends() const { return restrictedFriends; }
-    const std::vector<std::string>& getBlockedUsers() const { return blockedUsers; }
+    const IdSet& getFriendIds() const { return friends; }
+    const IdSet& getFriendRequestIds() const { return friendRequests; }
+    const IdSet& getRestrictedFriendIds() const { return restrictedFriends; }
+    const IdSet& getBlockedUserIds() const { return blockedUsers; }
+    std::vector<std::string> getFriends() const { return namesOf(friends); }
+    std::vector<std::string> getFriendRequests() const { return namesOf(friendRequests); }
+    std::vector<std::string> getRestrictedFriends() const { return namesOf(restrictedFriends); }
+    std::vector<std::string> getBlockedUsers() const { return namesOf(blockedUsers); }
     const std::vector<Post*>& getPosts() const { return posts; }
 
     // Setters
-    void setUsername(const std::string& username) { this->username = username; }
-    void setEmail(const std::string& email) { this->email = email; }
-    void setPassword(const std::string& password) { this->password = password; }
-    void setGender(const std::string& gender) { this->gender = gender; }
-    void setBot(bool bot) { isUserBot = bot; }
-    void setPublic(bool pub) { isPublicProfile = pub; }
+    void setUsername(const std::string& username);
+    void setEmail(const std::string& email);
+    void setPassword(const std::string& password) { this->password = password; touch(); }
+    void setGender(const std::string& gender) { this->gender = gender; touch(); }
+    void setBot(bool bot) { isUserBot = bot; touch(); }
+    void setPublic(bool pub) { isPublicProfile = pub; touch(); }
     
+    // Username <-> id mapping through the global interner
+    static UserId idOf(const std::string& username);
+    // Like idOf but never interns; returns INVALID_USER_ID for unknown names
+    static UserId findId(const std::string& username);
+    static const std::string& nameOf(UserId id);
+    static std::vector<std::string> namesOf(const IdSet& ids);
+
     // Friend management
-    void addFriend(const std::string& friendUsername);
-    void removeFriend(const std::string& friendUsername);
-    void addFriendRequest(const std::string& fromUsername);
-    void removeFriendRequest(const std::string& fromUsername);
-    bool hasFriend(const std::string& username) const;
-    bool hasFriendRequest(const std::string& username) const;
-    bool isFriend(const std::string& username) const;
+    void addFriend(UserId friendId);
+    void removeFriend(UserId friendId);
+    void addFriendRequest(UserId fromId);
+    void removeFriendRequest(UserId fromId);
+    bool hasFriend(UserId friendId) const;
+    bool hasFriendRequest(UserId fromId) const;
+    bool isFriend(UserId friendId) const { return friends.contains(friendId); }
+
+    void addFriend(const std::string& friendUsername) { addFriend(idOf(friendUsername)); }
+    void removeFriend(const std::string& friendUsername) { removeFriend(findId(friendUsername)); }
+    void addFriendRequest(const std::string& fromUsername) { addFriendRequest(idOf(fromUsername)); }
+    void removeFriendRequest(const std::string& fromUsername) { removeFriendRequest(findId(fromUsername)); }
+    bool hasFriend(const std::string& username) const { return hasFriend(findId(username)); }
+    bool hasFriendRequest(const std::string& username) const { return hasFriendRequest(findId(username)); }
+    bool isFriend(const std::string& username) const { return hasFriend(findId(username)); }
     
     // Password management
     bool checkPassword(const std::string& password) const;
     bool changePassword(const std::string& oldPassword, const std::string& newPassword);
     
     // Friend restrictions
-    void restrictFriend(const std::string& friendUsername);
-    void unrestrictFriend(const std::string& friendUsername);
-    bool isRestrictedFriend(const std::string& username) const;
+    void restrictFriend(UserId friendId);
+    void unrestrictFriend(UserId friendId);
+    bool isRestrictedFriend(UserId friendId) const;
+    void restrictFriend(const std::string& friendUsername) { restrictFriend(idOf(friendUsername)); }
+    void unrestrictFriend(const std::string& friendUsername) { unrestrictFriend(findId(friendUsername)); }
+    bool isRestrictedFriend(const std::string& username) const { return isRestrictedFriend(findId(username)); }
     
     // User blocking
-    void blockUser(const std::string& username);
-    void unblockUser(const std::string& username);
-    bool isBlocked(const std::string& username) const;
+    void blockUser(UserId userId);
+    void unblockUser(UserId userId);
+    bool isBlocked(UserId userId) const;
+    void blockUser(const std::string& username) { blockUser(idOf(username)); }
+    void unblockUser(const std::string& username) { unblockUser(findId(username)); }
+    bool isBlocked(const std::string& username) const { return isBlocked(findId(username)); }
     
-    // Post management
-    void addPost(Post* post) {
-        if (post) {
-            posts.push_back(post);
-        }
-    }
+    // Post management; posts are kept in chronological order (see Post::olderThan)
+    void addPost(Post* post);
 
+    // Unlinks the post; whoever owns it deletes it
     bool removePost(Post* post) {
         auto it = std::find(posts.begin(), posts.end(), post);
         if (it == posts.end()) return false;
         
         posts.erase(it);
-        delete post;
         return true;
     }
     
@@ -98,7 +126,7 @@ public:
     
     // Operators
     std::vector<Post*> operator+(const User& other) const; // Common posts
-    std::vector<User*> operator&(const User& other) const; // Mutual friends
+    std::vector<User*> operator&(const User& other) const; // Mutual friends (needs a UserDirectory)
 };
 
 #endif
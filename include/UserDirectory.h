@@ -0,0 +1,59 @@
+#ifndef USERDIRECTORY_H
+#define USERDIRECTORY_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "UserId.h"
+#include "UserSearchIndex.h"
+
+class User;
+
+// Non-owning registry of users with O(1) lookup by username and email.
+// Users added here keep a back-pointer so setUsername/setEmail re-index them.
+class UserDirectory {
+private:
+    std::vector<User*> users;
+    std::unordered_map<std::string, User*> usernameIndex;
+    std::unordered_map<std::string, User*> emailIndex;
+    std::unordered_map<UserId, User*> idIndex;
+    UserSearchIndex searchIndex;
+
+public:
+    UserDirectory() = default;
+    ~UserDirectory();
+
+    UserDirectory(const UserDirectory&) = delete;
+    UserDirectory& operator=(const UserDirectory&) = delete;
+
+    // Returns false if the username or email is already taken
+    bool addUser(User* user);
+    // Unregisters the user without deleting it
+    bool removeUser(User* user);
+    void clear();
+
+    User* findByUsername(const std::string& username) const;
+    User* findByEmail(const std::string& email) const;
+    User* findById(UserId id) const;
+    bool hasUsername(const std::string& username) const { return usernameIndex.count(username) > 0; }
+    bool hasEmail(const std::string& email) const { return emailIndex.count(email) > 0; }
+
+    // Type-ahead search over usernames and emails (see UserSearchIndex)
+    std::vector<User*> search(const std::string& query, std::size_t limit = 0) const {
+        return searchIndex.search(query, limit, *this);
+    }
+    UserSearchIndex& getSearchIndex() { return searchIndex; }
+
+    // Called by User when its key fields change
+    bool reindexUsername(User* user, const std::string& oldUsername, const std::string& newUsername);
+    bool reindexEmail(User* user, const std::string& oldEmail, const std::string& newEmail);
+
+    const std::vector<User*>& getUsers() const { return users; }
+    std::size_t size() const { return users.size(); }
+    bool empty() const { return users.empty(); }
+
+    std::vector<User*>::const_iterator begin() const { return users.begin(); }
+    std::vector<User*>::const_iterator end() const { return users.end(); }
+};
+
+#endif
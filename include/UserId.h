@@ -0,0 +1,12 @@
+#ifndef USERID_H
+#define USERID_H
+
+#include <cstdint>
+#include <limits>
+
+// Dense numeric identity for a username, handed out by StringInterner::usernames()
+using UserId = std::uint32_t;
+
+constexpr UserId INVALID_USER_ID = std::numeric_limits<UserId>::max();
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef USERSEARCHINDEX_H
+#define USERSEARCHINDEX_H
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "IdSet.h"
+
+class User;
+class UserDirectory;
+
+// Type-ahead index over usernames and emails, maintained by UserDirectory.
+// Case-folded keys live in ordered sets for prefix range scans, and a
+// trigram -> UserId index answers infix queries of three or more characters.
+class UserSearchIndex {
+private:
+    using KeySet = std::set<std::pair<std::string, User*>>;
+
+    KeySet usernameKeys;
+    KeySet emailKeys;
+    std::unordered_map<std::uint32_t, IdSet> trigrams;
+    bool infixEnabled = true;
+
+    static void collectTrigrams(const std::string& key, std::vector<std::uint32_t>& out);
+    void addTrigrams(const std::string& username, const std::string& email, UserId id);
+    void removeTrigrams(const std::string& username, const std::string& email, UserId id);
+
+public:
+    static std::string fold(const std::string& value);
+
+    void addUser(User* user);
+    // Explicit keys, for re-indexing before the User's own fields change
+    void addUser(User* user, const std::string& username, const std::string& email);
+    void removeUser(User* user, const std::string& username, const std::string& email);
+    void clear();
+
+    // Trigram memory grows with total key length; large deployments may prefer prefix-only
+    void setInfixEnabled(bool enabled);
+    bool isInfixEnabled() const { return infixEnabled; }
+
+    // Username prefix matches, then email prefix matches, then infix matches.
+    // limit == 0 means unlimited; an empty query lists users in key order.
+    std::vector<User*> search(const std::string& query, std::size_t limit,
+                              const UserDirectory& directory) const;
+};
+
+#endif
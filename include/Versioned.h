@@ -0,0 +1,33 @@
+#ifndef VERSIONED_H
+#define VERSIONED_H
+
+#include <cstdint>
+
+// Change stamp for a persisted record. Stamps come from one process-wide
+// clock, so a record has changed since a save taken at clock value S exactly
+// when its version is greater than S. New and copied records start changed.
+class Versioned {
+private:
+    static inline std::uint64_t clock = 0;
+    std::uint64_t version;
+
+public:
+    Versioned() : version(tick()) {}
+    Versioned(const Versioned&) : version(tick()) {}
+    Versioned& operator=(const Versioned&) {
+        touch();
+        return *this;
+    }
+
+    std::uint64_t getVersion() const { return version; }
+    bool changedSince(std::uint64_t savedAt) const { return version > savedAt; }
+    // Marks the record as changed
+    void touch() { version = tick(); }
+
+    // Current clock value, i.e. the version of the latest change
+    static std::uint64_t now() { return clock; }
+    // Advances the clock, for changes not tied to one record
+    static std::uint64_t tick() { return ++clock; }
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef WRITEAHEADLOG_H
+#define WRITEAHEADLOG_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Append-only log of mutations, one record per line:
+//   OP|field|field...\n
+// '|', '\n' and '\\' inside fields are backslash-escaped. A record only counts
+// once its trailing newline is on disk, so a torn final line from a crash is
+// ignored on replay.
+//
+// Appends go through a buffered FILE and are fsync'd in groups: after
+// syncEvery records or syncInterval, whichever comes first, and on sync().
+// A crash can therefore lose at most one unsynced group.
+//
+// A checkpoint retires the log instead of truncating it: the file is renamed
+// to "<path>.<generation>" and a fresh log is started, so mutations logged
+// while the snapshot is being written in the background are never dropped.
+// Retired logs are deleted once a snapshot covering them is on disk, and are
+// replayed (oldest first, before the live log) if one is still around.
+class WriteAheadLog {
+public:
+    using Record = std::vector<std::string>;
+
+    static constexpr std::size_t DEFAULT_SYNC_EVERY = 32;
+    static constexpr std::chrono::milliseconds DEFAULT_SYNC_INTERVAL{200};
+
+private:
+    std::string path;
+    std::FILE* file = nullptr;
+    std::size_t syncEvery;
+    std::chrono::milliseconds syncInterval;
+    std::size_t records = 0;   // records in the log file, synced or not
+    std::size_t unsynced = 0;
+    std::chrono::steady_clock::time_point lastSync;
+
+    void trimTornTail();
+
+public:
+    explicit WriteAheadLog(const std::string& path,
+                           std::size_t syncEvery = DEFAULT_SYNC_EVERY,
+                           std::chrono::milliseconds syncInterval = DEFAULT_SYNC_INTERVAL);
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // Opens the log for appending, creating it if needed
+    bool open();
+    void close();
+    bool isOpen() const { return file != nullptr; }
+
+    void append(const Record& record);
+    // Flushes buffered records and fsyncs the file
+    void sync();
+
+    // Calls apply for every complete record in the log file, in order.
+    // Returns the number of records replayed.
+    std::size_t replay(const std::function<void(const Record&)>& apply);
+    // Empties the log once its records are captured in a snapshot
+    void truncate();
+    // Moves the records logged so far to retiredPath(generation) and starts an
+    // empty log. False if the log could not be moved; it then keeps its records.
+    bool retire(std::uint64_t generation);
+    std::string retiredPath(std::uint64_t generation) const;
+
+    // Retired logs next to the log at path, oldest generation first
+    static std::vector<std::pair<std::uint64_t, std::string>> retiredLogs(const std::string& path);
+    static void removeRetired(const std::string& path, std::uint64_t upToGeneration);
+
+    std::size_t size() const { return records; }
+    std::size_t pending() const { return unsynced; }
+    const std::string& getPath() const { return path; }
+
+    static std::string encode(const Record& record);
+    static Record decode(const std::string& line);
+};
+
+#endif
@@ -0,0 +1,49 @@
+#include "../include/AtomicFile.h"
+#include <filesystem>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+void AtomicFile::sync(std::FILE* file) {
+    std::fflush(file);
+#ifdef _WIN32
+    _commit(_fileno(file));
+#else
+    fsync(fileno(file));
+#endif
+}
+
+void AtomicFile::syncDirectory(const std::string& path) {
+#ifndef _WIN32
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    int dir = ::open(parent.empty() ? "." : parent.c_str(), O_RDONLY);
+    if (dir < 0) return;
+    fsync(dir);
+    ::close(dir);
+#else
+    (void)path;  // NTFS journals renames; there is no directory handle to flush
+#endif
+}
+
+bool AtomicFile::write(const std::string& path, std::string_view bytes) {
+    std::string tempPath = path + ".tmp";
+    std::FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (!file) return false;
+    bool ok = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    if (ok) sync(file);
+    ok = std::fclose(file) == 0 && ok;
+
+    std::error_code ec;
+    if (ok) std::filesystem::rename(tempPath, path, ec);
+    if (!ok || ec) {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    // Without this the rename can be lost in a crash, after the caller has
+    // already acted on the new contents being durable
+    syncDirectory(path);
+    return true;
+}
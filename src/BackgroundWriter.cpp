@@ -0,0 +1,64 @@
+#include "../include/BackgroundWriter.h"
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+BackgroundWriter::BackgroundWriter() : worker([this] { loop(); }) {}
+
+BackgroundWriter::~BackgroundWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void BackgroundWriter::submit(const std::string& key, std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.erase(std::remove_if(queue.begin(), queue.end(),
+                                   [&](const Job& queued) { return queued.key == key; }),
+                    queue.end());
+        queue.push_back({key, std::move(job)});
+    }
+    wake.notify_one();
+}
+
+void BackgroundWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return queue.empty() && !busy; });
+}
+
+std::size_t BackgroundWriter::pending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return queue.size() + (busy ? 1 : 0);
+}
+
+std::size_t BackgroundWriter::completedJobs() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return completed;
+}
+
+void BackgroundWriter::loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) break;  // stopping, and everything is written
+
+        Job job = std::move(queue.front());
+        queue.pop_front();
+        busy = true;
+        lock.unlock();
+        try {
+            job.run();
+        } catch (const std::exception& e) {
+            std::cout << "[Error]        Background save '" << job.key << "' failed: " << e.what() << std::endl;
+        }
+        lock.lock();
+        busy = false;
+        ++completed;
+        if (queue.empty()) idle.notify_all();
+    }
+    idle.notify_all();
+}
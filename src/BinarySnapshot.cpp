@@ -0,0 +1,235 @@
+#include "../include/BinarySnapshot.h"
+#include "../include/User.h"
+#include "../include/Post.h"
+#include "../include/AtomicFile.h"
+#include "../include/StorageEngine.h"
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+
+const char MAGIC[8] = {'F', 'B', 'S', 'N', 'A', 'P', '\r', '\n'};
+
+std::uint64_t align8(std::uint64_t offset) {
+    return (offset + 7) & ~std::uint64_t(7);
+}
+
+class StringPool {
+private:
+    std::string bytes;
+
+public:
+    BinarySnapshot::StringRef add(std::string_view value) {
+        BinarySnapshot::StringRef ref{bytes.size(), static_cast<std::uint32_t>(value.size()), 0};
+        bytes.append(value.data(), value.size());
+        return ref;
+    }
+    const std::string& data() const { return bytes; }
+};
+
+template <typename T>
+void copySection(std::string& image, std::uint64_t offset, const std::vector<T>& values) {
+    if (!values.empty()) {
+        std::memcpy(&image[offset], values.data(), values.size() * sizeof(T));
+    }
+}
+
+// True if [offset, offset + count * size) lies inside the file and is aligned
+bool fits(std::uint64_t offset, std::uint64_t count, std::size_t size, std::uint64_t fileSize) {
+    if (offset % 8 != 0 || offset > fileSize) return false;
+    return count <= (fileSize - offset) / size;
+}
+
+}
+
+std::string BinarySnapshot::encode(const std::vector<User*>& userList,
+                                   const std::vector<Post*>& postList,
+                                   const std::vector<Message>& messageList,
+                                   const TextSizes& textSizes, const TextHashes& textHashes) {
+    StringPool pool;
+    std::unordered_map<UserId, std::uint32_t> indexOf;
+    indexOf.reserve(userList.size());
+    for (std::size_t i = 0; i < userList.size(); ++i) {
+        indexOf.emplace(userList[i]->getId(), static_cast<std::uint32_t>(i));
+    }
+
+    std::vector<UserRecord> userRecords;
+    std::vector<std::uint64_t> friendOffsetValues{0};
+    std::vector<std::uint32_t> friendValues;
+    userRecords.reserve(userList.size());
+    for (const User* user : userList) {
+        userRecords.push_back({pool.add(user->getUsername()), pool.add(user->getEmail()),
+                               pool.add(user->getPassword()), pool.add(user->getGender()),
+                               StorageEngine::userFlags(*user), 0});
+        for (UserId friendId : user->getFriendIds()) {
+            auto it = indexOf.find(friendId);
+            if (it != indexOf.end()) friendValues.push_back(it->second);
+        }
+        friendOffsetValues.push_back(friendValues.size());
+    }
+
+    std::vector<PostRecord> postRecords;
+    std::vector<std::uint64_t> likeOffsetValues{0};
+    std::vector<std::uint32_t> likeValues;
+    postRecords.reserve(postList.size());
+    for (const Post* post : postList) {
+        auto author = post->getUser() ? indexOf.find(post->getUser()->getId()) : indexOf.end();
+        if (author == indexOf.end()) continue;
+        postRecords.push_back({post->getId(), author->second, static_cast<std::uint32_t>(post->getPrivacy()), 0,
+                               pool.add(post->getTimestamp()), pool.add(post->getContent())});
+        for (UserId liker : post->getLikeIds()) {
+            auto it = indexOf.find(liker);
+            if (it != indexOf.end()) likeValues.push_back(it->second);
+        }
+        likeOffsetValues.push_back(likeValues.size());
+    }
+
+    std::vector<MessageRecord> messageRecords;
+    messageRecords.reserve(messageList.size());
+    for (const Message& message : messageList) {
+        messageRecords.push_back({pool.add(message.from), pool.add(message.to),
+                                  pool.add(message.text), pool.add(message.timestamp)});
+    }
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.headerSize = sizeof(Header);
+    for (std::size_t i = 0; i < TEXT_FILES; ++i) {
+        header.textSizes[i] = textSizes[i];
+        header.textHashes[i] = textHashes[i];
+    }
+    header.userCount = userRecords.size();
+    header.postCount = postRecords.size();
+    header.messageCount = messageRecords.size();
+    header.friendCount = friendValues.size();
+    header.likeCount = likeValues.size();
+
+    std::uint64_t offset = align8(sizeof(Header));
+    auto place = [&](std::uint64_t bytes) {
+        std::uint64_t start = offset;
+        offset = align8(offset + bytes);
+        return start;
+    };
+    header.usersOffset = place(userRecords.size() * sizeof(UserRecord));
+    header.friendOffsetsOffset = place(friendOffsetValues.size() * sizeof(std::uint64_t));
+    header.friendsOffset = place(friendValues.size() * sizeof(std::uint32_t));
+    header.postsOffset = place(postRecords.size() * sizeof(PostRecord));
+    header.likeOffsetsOffset = place(likeOffsetValues.size() * sizeof(std::uint64_t));
+    header.likesOffset = place(likeValues.size() * sizeof(std::uint32_t));
+    header.messagesOffset = place(messageRecords.size() * sizeof(MessageRecord));
+    header.stringsOffset = offset;
+    header.stringsSize = pool.data().size();
+    header.fileSize = header.stringsOffset + header.stringsSize;
+
+    std::string image(header.fileSize, '\0');
+    std::memcpy(&image[0], &header, sizeof(header));
+    copySection(image, header.usersOffset, userRecords);
+    copySection(image, header.friendOffsetsOffset, friendOffsetValues);
+    copySection(image, header.friendsOffset, friendValues);
+    copySection(image, header.postsOffset, postRecords);
+    copySection(image, header.likeOffsetsOffset, likeOffsetValues);
+    copySection(image, header.likesOffset, likeValues);
+    copySection(image, header.messagesOffset, messageRecords);
+    if (!pool.data().empty()) {
+        std::memcpy(&image[header.stringsOffset], pool.data().data(), pool.data().size());
+    }
+    return image;
+}
+
+bool BinarySnapshot::write(const std::string& path,
+                           const std::vector<User*>& userList,
+                           const std::vector<Post*>& postList,
+                           const std::vector<Message>& messageList,
+                           const TextSizes& textSizes, const TextHashes& textHashes) {
+    return AtomicFile::write(path, encode(userList, postList, messageList, textSizes, textHashes));
+}
+
+bool BinarySnapshot::open(const std::string& path) {
+    close();
+    if (!file.open(path)) return false;
+
+    const std::uint64_t size = file.size();
+    const Header* candidate = reinterpret_cast<const Header*>(file.data());
+    bool valid = size >= sizeof(Header) &&
+                 std::memcmp(candidate->magic, MAGIC, sizeof(MAGIC)) == 0 &&
+                 candidate->version == VERSION &&
+                 candidate->headerSize == sizeof(Header) &&
+                 candidate->fileSize == size &&
+                 fits(candidate->usersOffset, candidate->userCount, sizeof(UserRecord), size) &&
+                 fits(candidate->friendOffsetsOffset, candidate->userCount + 1, sizeof(std::uint64_t), size) &&
+                 fits(candidate->friendsOffset, candidate->friendCount, sizeof(std::uint32_t), size) &&
+                 fits(candidate->postsOffset, candidate->postCount, sizeof(PostRecord), size) &&
+                 fits(candidate->likeOffsetsOffset, candidate->postCount + 1, sizeof(std::uint64_t), size) &&
+                 fits(candidate->likesOffset, candidate->likeCount, sizeof(std::uint32_t), size) &&
+                 fits(candidate->messagesOffset, candidate->messageCount, sizeof(MessageRecord), size) &&
+                 candidate->stringsOffset <= size &&
+                 candidate->stringsSize <= size - candidate->stringsOffset;
+    if (!valid) {
+        file.close();
+        return false;
+    }
+
+    const char* base = file.data();
+    head = candidate;
+    users = reinterpret_cast<const UserRecord*>(base + head->usersOffset);
+    friendOffsets = reinterpret_cast<const std::uint64_t*>(base + head->friendOffsetsOffset);
+    friends = reinterpret_cast<const std::uint32_t*>(base + head->friendsOffset);
+    posts = reinterpret_cast<const PostRecord*>(base + head->postsOffset);
+    likeOffsets = reinterpret_cast<const std::uint64_t*>(base + head->likeOffsetsOffset);
+    likes = reinterpret_cast<const std::uint32_t*>(base + head->likesOffset);
+    messages = reinterpret_cast<const MessageRecord*>(base + head->messagesOffset);
+    strings = base + head->stringsOffset;
+    return true;
+}
+
+void BinarySnapshot::close() {
+    file.close();
+    head = nullptr;
+    users = nullptr;
+    friendOffsets = nullptr;
+    friends = nullptr;
+    posts = nullptr;
+    likeOffsets = nullptr;
+    likes = nullptr;
+    messages = nullptr;
+    strings = nullptr;
+}
+
+bool BinarySnapshot::matches(const TextSizes& textSizes) const {
+    if (!head) return false;
+    for (std::size_t i = 0; i < TEXT_FILES; ++i) {
+        if (head->textSizes[i] != textSizes[i]) return false;
+    }
+    return true;
+}
+
+bool BinarySnapshot::matchesContent(const TextHashes& textHashes) const {
+    if (!head) return false;
+    for (std::size_t i = 0; i < TEXT_FILES; ++i) {
+        if (head->textHashes[i] != textHashes[i]) return false;
+    }
+    return true;
+}
+
+BinarySnapshot::IndexRange BinarySnapshot::range(const std::uint64_t* offsets, const std::uint32_t* values,
+                                                 std::size_t i, std::uint64_t total) const {
+    std::uint64_t first = offsets[i];
+    std::uint64_t last = offsets[i + 1];
+    if (first > last || last > total) {
+        return {values, values};
+    }
+    return {values + first, values + last};
+}
+
+BinarySnapshot::Message BinarySnapshot::message(std::size_t i) const {
+    const MessageRecord& record = messages[i];
+    return {str(record.from), str(record.to), str(record.text), str(record.timestamp)};
+}
+
+std::string_view BinarySnapshot::str(const StringRef& ref) const {
+    if (!head || ref.offset > head->stringsSize || ref.length > head->stringsSize - ref.offset) {
+        return {};
+    }
+    return std::string_view(strings + ref.offset, ref.length);
+}
@@ -0,0 +1,102 @@
+#include "../include/BinaryStorage.h"
+#include "../include/BinarySnapshot.h"
+#include <algorithm>
+#include <iostream>
+#include <unordered_set>
+
+static_assert(static_cast<std::size_t>(TextStorage::FILE_COUNT) == BinarySnapshot::TEXT_FILES,
+              "snapshot must record every text file");
+
+namespace {
+
+// Copies per-file sizes or hashes into the snapshot header layout
+std::array<std::uint64_t, BinarySnapshot::TEXT_FILES> toHeaderLayout(const TextStorage::FileSizes& values) {
+    std::array<std::uint64_t, BinarySnapshot::TEXT_FILES> layout{};
+    std::copy(values.begin(), values.end(), layout.begin());
+    return layout;
+}
+
+}
+
+BinaryStorage::BinaryStorage(const std::string& path, const TextStorage* text)
+    : path(path), text(text) {}
+
+bool BinaryStorage::load(Sink& sink, unsigned entities, StartupReport*) {
+    BinarySnapshot snapshot;
+    if (!snapshot.open(path)) {
+        std::cout << "[Warning]      No usable snapshot at " << path << std::endl;
+        return false;
+    }
+    // Sizes reject most stale snapshots without reading the text files; the
+    // hashes catch same-length edits and half-committed checkpoints
+    if (text && (!snapshot.matches(toHeaderLayout(text->fileSizes())) ||
+                 !snapshot.matchesContent(toHeaderLayout(text->fileHashes())))) {
+        std::cout << "[Warning]      Snapshot does not match the text files, ignoring it" << std::endl;
+        return false;
+    }
+
+    auto username = [&](std::size_t i) { return snapshot.str(snapshot.user(i).username); };
+
+    if (entities & USERS) {
+        for (std::size_t i = 0; i < snapshot.userCount(); ++i) {
+            const auto& record = snapshot.user(i);
+            sink.user({snapshot.str(record.username), snapshot.str(record.email),
+                       snapshot.str(record.password), snapshot.str(record.gender), record.flags});
+        }
+    }
+
+    for (std::size_t i = 0; i < snapshot.postCount(); ++i) {
+        const auto& record = snapshot.post(i);
+        if (record.author >= snapshot.userCount()) continue;
+        if (entities & POSTS) {
+            sink.post({record.id, username(record.author), toPrivacy(record.privacy),
+                       snapshot.str(record.timestamp), snapshot.str(record.content)});
+        }
+        if (entities & LIKES) {
+            for (std::uint32_t j : snapshot.likesOf(i)) {
+                if (j < snapshot.userCount()) sink.like({record.id, username(j)});
+            }
+        }
+    }
+
+    // Adjacency is stored as each user holds it, usually in both directions;
+    // report each pair once, including pairs only one side holds
+    if (entities & FRIENDSHIPS) {
+        std::unordered_set<std::uint64_t> reported;
+        for (std::size_t i = 0; i < snapshot.userCount(); ++i) {
+            for (std::uint32_t j : snapshot.friendsOf(i)) {
+                if (j >= snapshot.userCount()) continue;
+                std::uint64_t low = std::min<std::uint64_t>(i, j), high = std::max<std::uint64_t>(i, j);
+                if (reported.insert((low << 32) | high).second) sink.friendship({username(low), username(high)});
+            }
+        }
+    }
+
+    if (entities & MESSAGES) {
+        for (std::size_t i = 0; i < snapshot.messageCount(); ++i) {
+            auto message = snapshot.message(i);
+            sink.message({message.from, message.to, message.timestamp, message.text});
+        }
+    }
+    return true;
+}
+
+bool BinaryStorage::encode(const Dataset& data, FileImages& images) {
+    if (data.entities != ALL || !data.users || !data.posts || !data.messages) {
+        std::cout << "[Error]        A snapshot needs the complete data set" << std::endl;
+        return false;
+    }
+
+    std::vector<BinarySnapshot::Message> messages;
+    messages.reserve(data.messages->size());
+    for (const auto& message : *data.messages) {
+        messages.push_back({message.from, message.to, message.text, message.timestamp});
+    }
+    std::string image = BinarySnapshot::encode(
+        *data.users, *data.posts, messages,
+        text ? toHeaderLayout(text->expectedSizes()) : BinarySnapshot::TextSizes{},
+        text ? toHeaderLayout(text->expectedHashes()) : BinarySnapshot::TextHashes{});
+    std::cout << "[Saving]       Snapshot to " << path << std::endl;
+    images.push_back({path, std::move(image)});
+    return true;
+}
@@ -12,6 +12,7 @@ Comment::~Comment() {
 void Comment::addLike(User* user) {
     if (std::find(likes.begin(), likes.end(), user) == likes.end()) {
         likes.push_back(user);
+        touch();
     }
 }
 
@@ -19,12 +20,14 @@ void Comment::removeLike(User* user) {
     auto it = std::find(likes.begin(), likes.end(), user);
     if (it != likes.end()) {
         likes.erase(it);
+        touch();
     }
 }
 
 void Comment::addReply(User* user, const std::string& content) {
     Comment* reply = new Comment(user, content);
     replies.push_back(reply);
+    touch();
 }
 
 void Comment::removeReply(Comment* reply) {
@@ -32,5 +35,6 @@ void Comment::removeReply(Comment* reply) {
     if (it != replies.end()) {
         replies.erase(it);
         delete reply;
+        touch();
     }
 }
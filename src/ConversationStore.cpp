@@ -0,0 +1,75 @@
+#include "../include/ConversationStore.h"
+
+void MessageLog::append(UserId from, std::int64_t epoch, std::string_view text) {
+    if (blocks.empty() || blockSize - blockUsed < text.size()) {
+        // A message longer than the next block gets one of its own
+        blockSize = std::max(text.size(), blocks.empty() ? FIRST_BLOCK : std::min(blockSize * 2, MAX_BLOCK));
+        blocks.emplace_back(new char[blockSize]);
+        blockUsed = 0;
+        arenaBytes += blockSize;
+    }
+    std::copy(text.begin(), text.end(), blocks.back().get() + blockUsed);
+
+    if (count % CHUNK_SIZE == 0) {
+        chunks.emplace_back();
+        chunks.back().reserve(CHUNK_SIZE);
+    }
+    chunks.back().push_back({epoch, from, static_cast<std::uint32_t>(blocks.size() - 1),
+                             static_cast<std::uint32_t>(blockUsed), static_cast<std::uint32_t>(text.size())});
+    blockUsed += text.size();
+    ++count;
+    touch();
+}
+
+std::size_t MessageLog::positionAt(std::int64_t epoch) const {
+    std::size_t low = 0, high = count;
+    while (low < high) {
+        std::size_t mid = low + (high - low) / 2;
+        if (record(mid).epoch < epoch) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+void ConversationStore::append(UserId from, UserId to, std::int64_t epoch, std::string_view text) {
+    logs[ConversationKey::of(from, to)].append(from, epoch, text);
+    ++messages;
+}
+
+const MessageLog* ConversationStore::find(UserId a, UserId b) const {
+    auto it = logs.find(ConversationKey::of(a, b));
+    return it != logs.end() ? &it->second : nullptr;
+}
+
+MessageRange ConversationStore::messagesBetween(UserId a, UserId b) const {
+    const MessageLog* log = find(a, b);
+    return log ? MessageRange(*log) : MessageRange();
+}
+
+MessageRange ConversationStore::messagesBetween(UserId a, UserId b, std::int64_t fromEpoch, std::int64_t toEpoch) const {
+    const MessageLog* log = find(a, b);
+    if (!log || fromEpoch >= toEpoch) return MessageRange();
+    return MessageRange(*log, log->positionAt(fromEpoch), log->positionAt(toEpoch));
+}
+
+MessagePage ConversationStore::page(UserId a, UserId b, const MessageCursor& cursor, std::size_t limit) const {
+    MessagePage result;
+    result.next = cursor;
+    const MessageLog* log = find(a, b);
+    if (!log || limit == 0) return result;
+
+    std::size_t last = std::min(cursor.before, log->size());
+    std::size_t first = last > limit ? last - limit : 0;
+    result.messages = MessageRange(*log, first, last);
+    result.next.before = first;
+    result.hasMore = first > 0;
+    return result;
+}
+
+void ConversationStore::clear() {
+    logs.clear();
+    messages = 0;
+}
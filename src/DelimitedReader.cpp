@@ -0,0 +1,113 @@
+#include "../include/DelimitedReader.h"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define DELIMITED_USE_SSE2 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+
+#ifdef DELIMITED_USE_SSE2
+inline unsigned lowestBit(unsigned mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+#endif
+
+}
+
+const char* DelimitedReader::findDelimiter(const char* first, const char* last, char delimiter) {
+#ifdef DELIMITED_USE_SSE2
+    const __m128i delimiters = _mm_set1_epi8(delimiter);
+    const __m128i newlines = _mm_set1_epi8('\n');
+    while (last - first >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, delimiters), _mm_cmpeq_epi8(chunk, newlines));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+        if (mask != 0) {
+            return first + lowestBit(mask);
+        }
+        first += 16;
+    }
+#endif
+    while (first < last && *first != delimiter && *first != '\n') {
+        ++first;
+    }
+    return first;
+}
+
+bool DelimitedReader::open(const std::string& path) {
+    mapping.close();
+    buffer.clear();
+    lineNumber = 0;
+
+    if (mapping.open(path)) {
+        begin = cursor = mapping.data();
+        end = cursor + mapping.size();
+        return true;
+    }
+
+    // Empty files cannot be mapped; anything else unmappable is read whole
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        begin = cursor = end = nullptr;
+        return false;
+    }
+    buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    begin = cursor = buffer.data();
+    end = cursor + buffer.size();
+    return true;
+}
+
+void DelimitedReader::attach(const char* first, const char* last) {
+    mapping.close();
+    buffer.clear();
+    lineNumber = 0;
+    begin = cursor = first;
+    end = last;
+}
+
+bool DelimitedReader::next(Record& record, std::size_t maxFields) {
+    if (maxFields == 0 || maxFields > MAX_FIELDS) maxFields = MAX_FIELDS;
+
+    while (cursor && cursor < end) {
+        ++lineNumber;
+        record.count = 0;
+        record.line = lineNumber;
+
+        const char* fieldStart = cursor;
+        const char* p = cursor;
+        for (;;) {
+            p = findDelimiter(p, end, delimiter);
+            if (p < end && *p == delimiter) {
+                if (record.count + 1 < maxFields) {
+                    record.fields[record.count++] = std::string_view(fieldStart, p - fieldStart);
+                    fieldStart = p + 1;
+                }
+                ++p;
+                continue;
+            }
+            break;  // newline or end of input
+        }
+
+        const char* lineEnd = p;
+        cursor = p < end ? p + 1 : end;
+
+        if (lineEnd > fieldStart && lineEnd[-1] == '\r') --lineEnd;
+        if (record.count == 0 && lineEnd == fieldStart) continue;  // empty line
+        record.fields[record.count++] = std::string_view(fieldStart, lineEnd - fieldStart);
+        return true;
+    }
+    return false;
+}
@@ -4,32 +4,78 @@
 #include <iostream>
 #include <algorithm>
 #include <set>
+#include <unordered_set>
 #include <chrono>
 #include <ctime>
 #include <filesystem>
+#include <bitset>
 #include "../include/FileManager.h"
+#include "../include/Timestamp.h"
 
-FacebookSystem::FacebookSystem() : currentUser(nullptr) {
+FacebookSystem::FacebookSystem()
+    : timelines(users, posts), wal(WAL_FILE), textStorage(DATA_DIR),
+      binaryStorage(SNAPSHOT_FILE, &textStorage), archive(MESSAGES_DIR), currentUser(nullptr) {
     try {
-        // Initialize vectors
+        // Initialize containers
         users.clear();
         posts.clear();
         
         // Create data directory if it doesn't exist
-        std::filesystem::path dataDir = "../data";
+        std::filesystem::path dataDir = DATA_DIR;
         if (!std::filesystem::exists(dataDir)) {
             std::filesystem::create_directories(dataDir);
             std::cout << "[Created]      Data directory at: " << dataDir.string() << std::endl;
         }
 
-        // Create default bots
-        CreateDefaultBots();
+        // Messages are read per conversation when opened; only the index is loaded
+        if (!startupReport.time("message index", [&] { return archive.open(); })) {
+            archive.create();
+            importingMessages = true;
+        }
 
-        // Load existing data
-        loadUsers();
-        loadPosts();
-        loadFriends();
-        loadMessages();
+        // Load the last snapshot, then the mutations logged since. The binary
+        // snapshot is used when it matches the text files; otherwise parse them.
+        std::cout << "\n[Loading]      Data..." << std::endl;
+        if (!startupReport.time("snapshot", [&] { return loadFrom(binaryStorage, StorageEngine::ALL); })) {
+            loadFrom(textStorage, StorageEngine::ALL, &startupReport);
+            snapshotStale = true;
+        }
+        // Everything after this point is a change to what is on disk
+        markSaved(StorageEngine::ALL);
+
+        // Default bots are created only once; their posts are persisted like any other
+        startupReport.time("bots", [&] { CreateDefaultBots(); });
+
+        startupReport.time("replay", [&] { return replayLog(); });
+        // The index is written last, so an interrupted import is redone
+        if (importingMessages) {
+            archive.sync();
+            archive.writeIndex();
+            importingMessages = false;
+            std::cout << "[Success]      Moved " << archive.size() << " messages to " << archive.getDirectory() << std::endl;
+        }
+        if (legacyMessages > 0) {
+            forcedDirty |= StorageEngine::MESSAGES;
+            legacyMessages = 0;
+        }
+        // Posts keep their saved ids unless those collide; duplicates or
+        // renumbered posts mean the files have to be rewritten
+        bool renumbered = droppedDuplicatePosts > 0;
+        for (const auto& [savedId, post] : loadedPostIds) {
+            if (savedId != post->getId()) {
+                renumbered = true;
+                break;
+            }
+        }
+        if (renumbered) {
+            forcedDirty |= StorageEngine::POSTS | StorageEngine::LIKES;
+        }
+        if (droppedDuplicatePosts > 0) {
+            std::cout << "[Cleanup]      Dropped " << droppedDuplicatePosts << " duplicate posts" << std::endl;
+        }
+        loadedPostIds.clear();
+        loadedPostKeys.clear();
+        droppedDuplicatePosts = 0;
         
         // Add default users if they don't exist
         if (users.empty()) {
@@ -37,15 +83,9 @@ FacebookSystem::FacebookSystem() : currentUser(nullptr) {
             createDefaultUsers();
             
             // Create some default posts
-            User* john = nullptr;
-            User* sarah = nullptr;
-            User* mike = nullptr;
-            
-            for (auto* user : users) {
-                if (user->getUsername() == "john") john = user;
-                else if (user->getUsername() == "sarah") sarah = user;
-                else if (user->getUsername() == "mike") mike = user;
-            }
+            User* john = users.findByUsername("john");
+            User* sarah = users.findByUsername("sarah");
+            User* mike = users.findByUsername("mike");
             
             if (john) {
                 currentUser = john;
@@ -66,12 +106,13 @@ FacebookSystem::FacebookSystem() : currentUser(nullptr) {
             }
             
             currentUser = nullptr;
-            
-            // Save all data
-            FileManager::saveUsers(users);
-            saveFriends();
-            saveMessages();
         }
+
+        if (hasUnsavedChanges()) {
+            startupReport.time("checkpoint", [&] { checkpoint(); });
+        }
+        wal.open();
+        startupReport.print();
     } catch (const std::exception& e) {
         std::cout << "[Error]        In FacebookSystem constructor: " << e.what() << std::endl;
         throw;
@@ -85,16 +126,16 @@ void FacebookSystem::createDefaultUsers() {
         User* user2 = new User("jane", "jane@example.com", "password456", "female");
         User* user3 = new User("bob", "bob@example.com", "password789", "male");
         
-        users.push_back(user1);
-        users.push_back(user2);
-        users.push_back(user3);
+        users.addUser(user1);
+        users.addUser(user2);
+        users.addUser(user3);
         
         // Add some friend connections
-        user1->addFriend(user2->getUsername());
-        user2->addFriend(user1->getUsername());
+        user1->addFriend(user2->getId());
+        user2->addFriend(user1->getId());
         
-        user2->addFriend(user3->getUsername());
-        user3->addFriend(user2->getUsername());
+        user2->addFriend(user3->getId());
+        user3->addFriend(user2->getId());
         
         // Create some posts
         createPost("Hello world!", user1);
@@ -105,37 +146,32 @@ void FacebookSystem::createDefaultUsers() {
 
 void FacebookSystem::CreateDefaultBots() {
     // Create only 2 default bots to avoid overwhelming the system
-    bool hasAlice = false;
-    bool hasBob = false;
-    
-    for (const auto& user : users) {
-        if (user->getUsername() == "Bot_Alice") {
-            hasAlice = true;
-        } else if (user->getUsername() == "Bot_Bob") {
-            hasBob = true;
-        }
-    }
+    bool hasAlice = users.hasUsername("Bot_Alice");
+    bool hasBob = users.hasUsername("Bot_Bob");
     
     std::string timestamp = getCurrentTimestamp();
     
+    // Flagged before their first post, so the timeline cache treats them as
+    // hot authors (merged at read time) from the start. Bots saved without
+    // the flag get it here; the change is persisted with the users file.
+    auto flagBot = [this](const std::string& name) {
+        User* bot = users.findByUsername(name);
+        if (bot && !bot->isBot()) bot->setBot(true);
+        return bot;
+    };
+
     if (!hasAlice) {
         registerUser("Bot_Alice", "bot1@example.com", "bot123", "female");
-        for (const auto& user : users) {
-            if (user->getUsername() == "Bot_Alice") {
-                createPost("Welcome to our Facebook community! 👋", user);
-                break;
-            }
-        }
+    }
+    if (User* alice = flagBot("Bot_Alice"); alice && !hasAlice) {
+        createPost("Welcome to our Facebook community! 👋", alice);
     }
 
     if (!hasBob) {
         registerUser("Bot_Bob", "bot2@example.com", "bot123", "male");
-        for (const auto& user : users) {
-            if (user->getUsername() == "Bot_Bob") {
-                createPost("Feel free to connect with others! 🤝", user);
-                break;
-            }
-        }
+    }
+    if (User* bob = flagBot("Bot_Bob"); bob && !hasBob) {
+        createPost("Feel free to connect with others! 🤝", bob);
     }
 }
 
@@ -146,7 +182,7 @@ void FacebookSystem::AddDefaultBots() {
     User* mainBot = new User("Bot_Alice", "bot.alice@bot.com", "bot123", "bot");
     mainBot->setBot(true);
     mainBot->setPublic(true);
-    users.push_back(mainBot);
+    users.addUser(mainBot);
     std::cout << "Created main bot: " << mainBot->getUsername() << std::endl;
     CreateBotPosts(mainBot);
 
@@ -159,7 +195,7 @@ void FacebookSystem::AddDefaultBots() {
         User* bot = new User(botName, botName + "@bot.com", "bot123", "bot");
         bot->setBot(true);
         bot->setPublic(true);
-        users.push_back(bot);
+        users.addUser(bot);
         std::cout << "Created friend request bot: " << bot->getUsername() << std::endl;
     }
     std::cout << "Finished creating all bots" << std::endl;
@@ -183,9 +219,7 @@ void FacebookSystem::CreateBotPosts(User* bot) {
     for (const auto& content : samplePosts) {
         auto now = std::chrono::system_clock::now();
         auto timestamp = std::to_string(std::chrono::system_clock::to_time_t(now));
-        Post* post = new Post(bot, content, timestamp);
-        posts.push_back(post);
-        bot->addPost(post);
+        storePost(std::make_unique<Post>(bot, content, timestamp));
         std::cout << "Created post: " << content << std::endl;
     }
     std::cout << "Finished creating posts for bot: " << bot->getUsername() << std::endl;
@@ -212,11 +246,11 @@ void FacebookSystem::SendBotFriendRequests() {
         // 2. Not already friends
         // 3. No pending request exists
         if (user->isBot() && 
-            !currentUser->hasFriend(user->getUsername()) && 
+            !currentUser->hasFriend(user->getId()) && 
             !hasPendingFriendRequest(user, currentUser)) {
             
             std::cout << "Sending friend request from bot: " << user->getUsername() << std::endl;
-            user->addFriendRequest(currentUser->getUsername());
+            user->addFriendRequest(currentUser->getId());
             requestsSent++;
         }
     }
@@ -233,19 +267,18 @@ bool FacebookSystem::login(const std::string& email, const std::string& password
     // Clear any existing notifications
     notifications.clear();
     
-    for (User* user : users) {
-        if (user->getEmail() == email && user->getPassword() == password) {
-            std::cout << "Login successful for user: " << user->getUsername() << std::endl;
-            currentUser = user;
-            
-            // Send friend requests from bots if not already friends
-            if (!user->isBot()) {
-                std::cout << "Sending bot friend requests..." << std::endl;
-                SendBotFriendRequests();
-            }
-            
-            return true;
+    User* user = users.findByEmail(email);
+    if (user && user->getPassword() == password) {
+        std::cout << "Login successful for user: " << user->getUsername() << std::endl;
+        currentUser = user;
+        
+        // Send friend requests from bots if not already friends
+        if (!user->isBot()) {
+            std::cout << "Sending bot friend requests..." << std::endl;
+            SendBotFriendRequests();
         }
+        
+        return true;
     }
     std::cout << "Login failed: Invalid credentials" << std::endl;
     return false;
@@ -255,23 +288,43 @@ void FacebookSystem::logout() {
     std::cout << "Logging out current user" << std::endl;
     if (currentUser) {
         std::cout << "User " << currentUser->getUsername() << " logged out" << std::endl;
-        FileManager::saveUsers(users);
-        saveFriends();
-        savePosts();  // Save posts when logging out
-        saveMessages();
+        // The log makes the session durable; the data files catch up in the background
+        wal.sync();
+        checkpoint();
         currentUser = nullptr;
         notifications.clear();
+        // Opened chats are read back from the archive when next needed
+        conversations.clear();
     }
 }
 
 bool FacebookSystem::areFriends(const User* user1, const User* user2) const {
     if (!user1 || !user2) return false;
-    return user1->hasFriend(user2->getUsername()) && user2->hasFriend(user1->getUsername());
+    return user1->hasFriend(user2->getId()) && user2->hasFriend(user1->getId());
 }
 
 bool FacebookSystem::hasPendingFriendRequest(const User* fromUser, const User* toUser) const {
     if (!fromUser || !toUser) return false;
-    return toUser->hasFriendRequest(fromUser->getUsername());
+    return toUser->hasFriendRequest(fromUser->getId());
+}
+
+std::vector<User*> FacebookSystem::getMutualFriends(const std::string& username) const {
+    if (!currentUser) return {};
+    
+    User* otherUser = findUserByUsername(username);
+    if (!otherUser) return {};
+    
+    return MutualFriends(users).mutualFriends(*currentUser, *otherUser);
+}
+
+std::vector<FriendSuggestion> FacebookSystem::suggestFriends(std::size_t count) const {
+    if (!currentUser) return {};
+    return MutualFriends(users).suggestFriends(*currentUser, count);
+}
+
+FeedPage FacebookSystem::getFeed(const FeedCursor& cursor, std::size_t pageSize) {
+    if (!currentUser) return {};
+    return timelines.getFeed(*currentUser, cursor, pageSize);
 }
 
 bool FacebookSystem::sendFriendRequest(const std::string& toUsername) {
@@ -287,7 +340,7 @@ bool FacebookSystem::sendFriendRequest(const std::string& toUsername) {
     if (hasPendingFriendRequest(currentUser, toUser)) return false;
     
     // Add friend request
-    toUser->addFriendRequest(currentUser->getUsername());
+    toUser->addFriendRequest(currentUser->getId());
     addNotification(toUser, currentUser->getUsername() + " sent you a friend request");
     return true;
 }
@@ -299,17 +352,18 @@ void FacebookSystem::acceptFriendRequest(const std::string& fromUsername) {
     if (!fromUser) return;
     
     // Add each other as friends
-    currentUser->addFriend(fromUsername);
-    fromUser->addFriend(currentUser->getUsername());
+    currentUser->addFriend(fromUser->getId());
+    fromUser->addFriend(currentUser->getId());
     
     // Remove friend request
-    currentUser->removeFriendRequest(fromUsername);
+    currentUser->removeFriendRequest(fromUser->getId());
+    timelines.invalidate(currentUser->getId());
+    timelines.invalidate(fromUser->getId());
     
     // Add notification
     addNotification(fromUser, currentUser->getUsername() + " accepted your friend request");
     
-    // Save changes
-    saveFriends();
+    logMutation({"FRIEND_ADD", currentUser->getUsername(), fromUser->getUsername()});
 }
 
 void FacebookSystem::rejectFriendRequest(const std::string& fromUsername) {
@@ -322,241 +376,313 @@ void FacebookSystem::rejectFriendRequest(const std::string& fromUsername) {
     if (!hasPendingFriendRequest(fromUser, currentUser)) return;
     
     // Remove friend request
-    currentUser->removeFriendRequest(fromUsername);
+    currentUser->removeFriendRequest(fromUser->getId());
     addNotification(fromUser, currentUser->getUsername() + " rejected your friend request");
 }
 
 FacebookSystem::~FacebookSystem() {
-    FileManager::saveUsers(users);
-    saveFriends();
-    saveMessages();
+    checkpoint();
+    flush();
+    wal.close();
     
-    // Clean up memory
-    for (auto user : users) {
-        delete user;
-    }
+    // Posts point at their authors, so they go first; the store owns them
+    posts.clear();
+    std::vector<User*> allUsers = users.getUsers();
     users.clear();
-    
-    for (auto post : posts) {
-        delete post;
+    for (auto user : allUsers) {
+        delete user;
     }
-    posts.clear();
 }
 
 void FacebookSystem::loadUsers() {
     std::cout << "\n[Loading]      Users..." << std::endl;
-    std::string filePath = "../data/users.txt";
-    std::cout << "[File]         Reading: " << filePath << std::endl;
-    
-    std::ifstream file(filePath);
-    if (!file.is_open()) {
-        std::cout << "[Warning]      Could not open " << filePath << std::endl;
-        return;
-    }
-
-    std::string line;
-    int lineCount = 0;
-    while (std::getline(file, line)) {
-        lineCount++;
-        std::istringstream iss(line);
-        std::string email, username, password, gender;
-        if (std::getline(iss, email, '|') &&
-            std::getline(iss, username, '|') &&
-            std::getline(iss, password, '|') &&
-            std::getline(iss, gender)) {
-            
-            User* user = new User(username, email, password, gender);
-            users.push_back(user);
-        }
-    }
-    std::cout << "[Success]      Read " << lineCount << " lines from " << filePath << std::endl;
-    std::cout << "[Success]      Loaded " << users.size() << " users\n" << std::endl;
-    file.close();
+    loadFrom(textStorage, StorageEngine::USERS);
 }
 
 void FacebookSystem::loadFriends() {
     std::cout << "\n[Loading]      Friendships..." << std::endl;
-    std::string filePath = "../data/friends.txt";
-    std::cout << "[File]         Reading: " << filePath << std::endl;
-    
-    std::ifstream file(filePath);
-    if (!file.is_open()) {
-        std::cout << "[Warning]      Could not open " << filePath << std::endl;
-        return;
-    }
-
-    std::string line;
-    int lineCount = 0;
-    while (std::getline(file, line)) {
-        lineCount++;
-        std::istringstream iss(line);
-        std::string user1, user2;
-        if (std::getline(iss, user1, '|') && std::getline(iss, user2)) {
-            User* userObj1 = findUserByUsername(user1);
-            User* userObj2 = findUserByUsername(user2);
-            
-            if (userObj1 && userObj2) {
-                userObj1->addFriend(user2);
-                userObj2->addFriend(user1);
-            }
-        }
-    }
-    std::cout << "[Success]      Read " << lineCount << " lines from " << filePath << std::endl;
-    std::cout << "[Success]      Loaded friendships\n" << std::endl;
-    file.close();
+    loadFrom(textStorage, StorageEngine::FRIENDSHIPS);
+    // Cached timelines were built against the old friend graph
+    timelines.clear();
 }
 
 void FacebookSystem::loadPosts() {
     std::cout << "\n[Loading]      Posts..." << std::endl;
-    std::string filePath = "../data/posts.txt";
-    std::cout << "[File]         Reading: " << filePath << std::endl;
-    
-    std::ifstream file(filePath);
-    if (!file.is_open()) {
-        std::cout << "[Warning]      Could not open " << filePath << std::endl;
-        return;
-    }
-
-    std::string line;
-    int lineCount = 0;
-    while (std::getline(file, line)) {
-        lineCount++;
-        std::istringstream iss(line);
-        std::string idStr, username, content, timestamp;
-        if (std::getline(iss, idStr, '|') &&
-            std::getline(iss, username, '|') &&
-            std::getline(iss, content, '|') &&
-            std::getline(iss, timestamp)) {
-            
-            User* user = findUserByUsername(username);
-            if (user) {
-                Post* post = createPost(content, user);
-                posts.push_back(post);
-            }
-        }
-    }
-    std::cout << "[Success]      Read " << lineCount << " lines from " << filePath << std::endl;
-    std::cout << "[Success]      Loaded " << posts.size() << " posts\n" << std::endl;
-    file.close();
+    loadFrom(textStorage, StorageEngine::POSTS);
 }
 
 void FacebookSystem::loadMessages() {
     std::cout << "\n[Loading]      Messages..." << std::endl;
-    std::string filePath = "../data/messages.txt";
-    std::cout << "[File]         Reading: " << filePath << std::endl;
-    
-    std::ifstream file(filePath);
-    if (!file.is_open()) {
-        std::cout << "[Warning]      Could not open " << filePath << std::endl;
-        return;
+    loadFrom(textStorage, StorageEngine::MESSAGES);
+}
+
+void FacebookSystem::loadLikes() {
+    std::cout << "\n[Loading]      Likes..." << std::endl;
+    loadFrom(textStorage, StorageEngine::LIKES);
+}
+
+bool FacebookSystem::loadFrom(StorageEngine& engine, unsigned entities, StartupReport* report) {
+    std::size_t knownUsers = users.size();
+    std::size_t knownPosts = posts.size();
+    if (!engine.load(*this, entities, report)) return false;
+    std::cout << "[Success]      Loaded " << users.size() - knownUsers << " users and "
+              << posts.size() - knownPosts << " posts from " << engine.name() << " storage\n" << std::endl;
+    return true;
+}
+
+User* FacebookSystem::findLoadedUser(std::string_view username) {
+    loadKey.assign(username);
+    return users.findByUsername(loadKey);
+}
+
+void FacebookSystem::user(const StorageEngine::UserRow& row) {
+    loadKey.assign(row.username);
+    if (users.hasUsername(loadKey)) return;
+    User* user = new User(loadKey, std::string(row.email), std::string(row.password), std::string(row.gender));
+    user->setBot(row.flags & StorageEngine::USER_BOT);
+    user->setPublic(row.flags & StorageEngine::USER_PUBLIC);
+    if (!users.addUser(user)) {
+        delete user;
     }
+}
 
-    std::string line;
-    int lineCount = 0;
-    while (std::getline(file, line)) {
-        lineCount++;
-        std::istringstream iss(line);
-        std::string from, to, message, timestamp;
-        if (std::getline(iss, from, '|') &&
-            std::getline(iss, to, '|') &&
-            std::getline(iss, message, '|') &&
-            std::getline(iss, timestamp)) {
-            
-            std::string key = createChatKey(from, to);
-            conversations[key].push_back({from, message});
-        }
+void FacebookSystem::post(const StorageEngine::PostRow& row) {
+    if (User* author = findLoadedUser(row.author)) {
+        restorePost(row.id, author, std::string(row.content), std::string(row.timestamp), row.privacy);
     }
-    std::cout << "[Success]      Read " << lineCount << " lines from " << filePath << std::endl;
-    std::cout << "[Success]      Loaded messages\n" << std::endl;
-    file.close();
 }
 
-void FacebookSystem::saveMessages() {
-    std::cout << "\n[Saving]       Messages..." << std::endl;
-    std::string filePath = "../data/messages.txt";
-    std::cout << "[File]         Writing to: " << filePath << std::endl;
-    
-    std::ofstream file(filePath);
-    if (!file.is_open()) {
-        std::cout << "[Error]        Could not open " << filePath << std::endl;
-        return;
+void FacebookSystem::like(const StorageEngine::LikeRow& row) {
+    auto post = loadedPostIds.find(row.postId);
+    User* user = findLoadedUser(row.username);
+    if (post != loadedPostIds.end() && user) {
+        post->second->addLike(user->getId());
     }
+}
 
-    int messageCount = 0;
-    for (const auto& conv : conversations) {
-        for (const auto& msg : conv.second) {
-            file << msg.first << "|" << msg.second << "\n";
-            messageCount++;
-        }
+void FacebookSystem::friendship(const StorageEngine::FriendshipRow& row) {
+    User* user1 = findLoadedUser(row.user1);
+    User* user2 = findLoadedUser(row.user2);
+    if (user1 && user2) {
+        user1->addFriend(user2->getId());
+        user2->addFriend(user1->getId());
     }
-    std::cout << "[Success]      Saved " << messageCount << " messages\n" << std::endl;
-    file.close();
 }
 
-void FacebookSystem::saveUsersToFile() {
-    std::cout << "\n[Saving]       Users..." << std::endl;
-    std::string filePath = "../data/users.txt";
-    std::cout << "[File]         Writing to: " << filePath << std::endl;
-    
-    std::ofstream file(filePath);
-    if (!file.is_open()) {
-        std::cout << "[Error]        Could not open " << filePath << std::endl;
-        return;
+void FacebookSystem::message(const StorageEngine::MessageRow& row) {
+    if (importingMessages) {
+        archive.append(row.from, row.to, row.timestamp, row.text);
     }
+    ++legacyMessages;
+}
+
+bool FacebookSystem::encodeTo(StorageEngine& engine, unsigned entities, StorageEngine::FileImages& images) {
+    // Messages are kept in the archive, so the data files carry none
+    std::vector<StorageEngine::MessageRow> messages;
+
+    StorageEngine::Dataset data;
+    data.users = &users.getUsers();
+    data.posts = &posts.getPosts();
+    data.messages = &messages;
+    data.entities = entities;
+    return engine.encode(data, images);
+}
+
+void FacebookSystem::saveText(unsigned entities) {
+    entities &= dirtyEntities();
+    StorageEngine::FileImages images;
+    if (entities == 0 || !encodeTo(textStorage, entities, images)) return;
+    markSaved(entities);
+    snapshotStale = true;
+    // A newer save of the same files replaces one that has not started yet
+    writer.submit(std::string(textStorage.name()) + ":" + std::to_string(entities),
+                  [images = std::move(images), failed = &saveFailed] {
+        if (!StorageEngine::commit(images)) *failed = true;
+    });
+}
 
-    for (const auto* user : users) {
-        file << user->getEmail() << "|"
-             << user->getUsername() << "|"
-             << user->getPassword() << "|"
-             << user->getGender() << "\n";
+unsigned FacebookSystem::dirtyEntities() const {
+    auto changedSince = [](const auto& records, std::uint64_t savedAt) {
+        return std::any_of(records.begin(), records.end(),
+                           [savedAt](const Versioned* record) { return record->changedSince(savedAt); });
+    };
+    const auto& userList = users.getUsers();
+    const auto& postList = posts.getPosts();
+
+    unsigned dirty = forcedDirty;
+    if (changedSince(userList, savedAt[TextStorage::USERS_FILE])) dirty |= StorageEngine::USERS;
+    if (changedSince(userList, savedAt[TextStorage::FRIENDS_FILE])) dirty |= StorageEngine::FRIENDSHIPS;
+    if (postsRemovedAt > savedAt[TextStorage::POSTS_FILE] ||
+        changedSince(postList, savedAt[TextStorage::POSTS_FILE])) dirty |= StorageEngine::POSTS;
+    if (postsRemovedAt > savedAt[TextStorage::LIKES_FILE] ||
+        changedSince(postList, savedAt[TextStorage::LIKES_FILE])) dirty |= StorageEngine::LIKES;
+    return dirty;
+}
+
+void FacebookSystem::markSaved(unsigned entities) {
+    for (std::size_t f = 0; f < TextStorage::FILE_COUNT; ++f) {
+        if (entities & (1u << f)) savedAt[f] = Versioned::now();
     }
-    std::cout << "[Success]      Saved " << users.size() << " users\n" << std::endl;
-    file.close();
+    forcedDirty &= ~entities;
+}
+
+bool FacebookSystem::hasUnsavedChanges() const {
+    return dirtyEntities() != 0 || snapshotStale || wal.size() > 0 || saveFailed ||
+           archive.hasUnindexedChanges();
+}
+
+void FacebookSystem::saveMessages() {
+    saveText(StorageEngine::MESSAGES);
+}
+
+void FacebookSystem::saveUsersToFile() {
+    saveText(StorageEngine::USERS);
 }
 
 void FacebookSystem::saveFriends() {
-    std::cout << "\n[Saving]       Friendships..." << std::endl;
-    std::string filePath = "../data/friends.txt";
-    std::cout << "[File]         Writing to: " << filePath << std::endl;
-    
-    std::ofstream file(filePath);
-    if (!file.is_open()) {
-        std::cout << "[Error]        Could not open " << filePath << std::endl;
+    saveText(StorageEngine::FRIENDSHIPS);
+}
+
+void FacebookSystem::savePosts() {
+    saveText(StorageEngine::POSTS);
+}
+
+void FacebookSystem::saveLikes() {
+    saveText(StorageEngine::LIKES);
+}
+
+void FacebookSystem::checkpoint() {
+    if (!hasUnsavedChanges()) return;
+    // What a failed save left behind is unknown, so everything is rewritten
+    if (saveFailed) {
+        forcedDirty = StorageEngine::ALL;
+    }
+    unsigned dirty = dirtyEntities();
+    std::cout << "\n[Checkpoint]   Compacting " << wal.size() << " log records, "
+              << std::bitset<TextStorage::FILE_COUNT>(dirty).count() << " changed files" << std::endl;
+    // Later mutations go to a fresh log; the retired one is deleted only once
+    // the files below are on disk, so a crash mid-save loses nothing
+    std::uint64_t generation = checkpointGeneration + 1;
+    if (!wal.retire(generation)) {
+        // Its records are still in the live log, which no checkpoint may remove
         return;
     }
+    checkpointGeneration = generation;
 
-    int friendshipCount = 0;
-    for (const auto* user : users) {
-        for (const auto& friendUsername : user->getFriends()) {
-            if (user->getUsername() < friendUsername) {
-                file << user->getUsername() << "|" << friendUsername << "\n";
-                friendshipCount++;
-            }
+    // The snapshot records the text files' sizes, so it is encoded last
+    StorageEngine::FileImages images;
+    if (!encodeTo(textStorage, dirty, images) ||
+        ((dirty != 0 || snapshotStale) && !encodeTo(binaryStorage, StorageEngine::ALL, images))) {
+        return;
+    }
+    markSaved(dirty);
+    snapshotStale = false;
+    // Appends the index does not cover are found by scanning the buckets, so
+    // a lost index write costs startup time, not messages
+    if (archive.hasUnindexedChanges()) {
+        images.push_back(archive.encodeIndex());
+    }
+
+    // Every checkpoint runs (none is coalesced away), since each one writes
+    // only the files changed since the previous one
+    bool full = dirty == StorageEngine::ALL;
+    std::string walPath = wal.getPath();
+    writer.submit("checkpoint:" + std::to_string(generation),
+                  [images = std::move(images), walPath, generation, full, failed = &saveFailed] {
+        if (!StorageEngine::commit(images)) {
+            *failed = true;
+        } else if (full || !*failed) {
+            *failed = false;
+            WriteAheadLog::removeRetired(walPath, generation);
         }
+    });
+}
+
+void FacebookSystem::flush() {
+    writer.flush();
+}
+
+void FacebookSystem::logMutation(const WriteAheadLog::Record& record) {
+    if (!wal.isOpen()) return;  // loading or replaying
+    wal.append(record);
+    if (wal.size() >= WAL_COMPACT_THRESHOLD) {
+        checkpoint();
     }
-    std::cout << "[Success]      Saved " << friendshipCount << " friendships\n" << std::endl;
-    file.close();
 }
 
-void FacebookSystem::savePosts() {
-    std::cout << "\n[Saving]       Posts..." << std::endl;
-    std::string filePath = "../data/posts.txt";
-    std::cout << "[File]         Writing to: " << filePath << std::endl;
-    
-    std::ofstream file(filePath);
-    if (!file.is_open()) {
-        std::cout << "[Error]        Could not open " << filePath << std::endl;
-        return;
+std::size_t FacebookSystem::replayLog() {
+    auto apply = [this](const WriteAheadLog::Record& record) { applyLogRecord(record); };
+    // Logs retired by checkpoints that never reached the disk come first
+    std::size_t replayed = 0;
+    for (const auto& [generation, path] : WriteAheadLog::retiredLogs(wal.getPath())) {
+        snapshotStale = true;  // so the next checkpoint removes it
+        WriteAheadLog retired(path);
+        replayed += retired.replay(apply);
+        checkpointGeneration = std::max(checkpointGeneration, generation);
+    }
+    replayed += wal.replay(apply);
+    archive.endReplay();
+    if (replayed > 0) {
+        std::cout << "[Success]      Replayed " << replayed << " log records" << std::endl;
     }
+    return replayed;
+}
 
-    for (const auto* post : posts) {
-        file << post->getId() << "|"
-             << post->getUser()->getUsername() << "|"
-             << post->getContent() << "|"
-             << post->getTimestamp() << "\n";
+void FacebookSystem::applyLogRecord(const WriteAheadLog::Record& record) {
+    const std::string& op = record[0];
+    auto postFor = [&](const std::string& idStr) -> Post* {
+        try {
+            auto it = loadedPostIds.find(std::stoi(idStr));
+            return it != loadedPostIds.end() ? it->second : nullptr;
+        } catch (const std::exception&) {
+            return nullptr;
+        }
+    };
+
+    if (op == "REGISTER" && record.size() == 5) {
+        User* user = new User(record[1], record[2], record[3], record[4]);
+        if (!users.addUser(user)) {
+            delete user;
+        }
+    } else if (op == "PASSWORD" && record.size() == 3) {
+        if (User* user = findUserByUsername(record[1])) {
+            user->setPassword(record[2]);
+        }
+    } else if ((op == "FRIEND_ADD" || op == "FRIEND_REMOVE") && record.size() == 3) {
+        User* a = findUserByUsername(record[1]);
+        User* b = findUserByUsername(record[2]);
+        if (!a || !b) return;
+        if (op == "FRIEND_ADD") {
+            a->addFriend(b->getId());
+            b->addFriend(a->getId());
+            a->removeFriendRequest(b->getId());
+        } else {
+            a->removeFriend(b->getId());
+            b->removeFriend(a->getId());
+        }
+    } else if (op == "POST" && record.size() == 6) {
+        User* author = findUserByUsername(record[2]);
+        if (!author || postFor(record[1])) return;
+        int privacy = std::atoi(record[3].c_str());
+        restorePost(std::atoi(record[1].c_str()), author, record[5], record[4],
+                    static_cast<PostPrivacy>(privacy));
+    } else if (op == "POST_DELETE" && record.size() == 2) {
+        if (Post* post = postFor(record[1])) {
+            forgetLoadedPost(post);
+            unstorePost(post);
+        }
+    } else if (op == "LIKE" && record.size() == 3) {
+        Post* post = postFor(record[1]);
+        User* user = findUserByUsername(record[2]);
+        if (post && user) {
+            post->addLike(user->getId());
+        }
+    } else if (op == "MESSAGE" && record.size() == 5) {
+        // Logged before messages had their own archive. A retired log is
+        // replayed again when a crash beat its removal, so skip what the
+        // archive already stores
+        archive.appendUnlessStored(record[1], record[2], record[3], record[4]);
     }
-    std::cout << "[Success]      Saved " << posts.size() << " posts\n" << std::endl;
-    file.close();
 }
 
 bool FacebookSystem::registerUser(const std::string& username, const std::string& email,
@@ -565,22 +691,20 @@ bool FacebookSystem::registerUser(const std::string& username, const std::string
     std::cout << "[Details]      Username: " << username << std::endl;
     std::cout << "[Details]      Email: " << email << std::endl;
     
-    // Check if username already exists
-    for (const auto* user : users) {
-        if (user->getUsername() == username) {
-            std::cout << "[Error]        Username already exists" << std::endl;
-            return false;
-        }
-        if (user->getEmail() == email) {
-            std::cout << "[Error]        Email already exists" << std::endl;
-            return false;
-        }
+    // Check if username or email already exists
+    if (users.hasUsername(username)) {
+        std::cout << "[Error]        Username already exists" << std::endl;
+        return false;
+    }
+    if (users.hasEmail(email)) {
+        std::cout << "[Error]        Email already exists" << std::endl;
+        return false;
     }
 
     // Create new user
     User* newUser = new User(username, email, password, gender);
-    users.push_back(newUser);
-    FileManager::saveUsers(users);
+    users.addUser(newUser);
+    logMutation({"REGISTER", username, email, password, gender});
     std::cout << "[Success]      User registered successfully\n" << std::endl;
     return true;
 }
@@ -593,30 +717,84 @@ bool FacebookSystem::resetPassword(const std::string& email, const std::string&
     // In a real application, we would verify the security answer here
     // For this demo, we'll just allow the password reset
     user->setPassword(newPassword);
-    FileManager::saveUsers(users);
+    logMutation({"PASSWORD", user->getUsername(), newPassword});
     return true;
 }
 
+Post* FacebookSystem::storePost(std::unique_ptr<Post> owned) {
+    Post* post = posts.addPost(std::move(owned));
+    if (!post) return nullptr;
+    post->getUser()->addPost(post);
+    searchIndex.addPost(post);
+    timelines.onPostCreated(*post);
+    logMutation({"POST", std::to_string(post->getId()), post->getAuthorUsername(),
+                 std::to_string(static_cast<int>(post->getPrivacy())),
+                 post->getTimestamp(), post->getContent()});
+    return post;
+}
+
+Post* FacebookSystem::restorePost(int savedId, User* author, const std::string& content,
+                                  const std::string& timestamp, PostPrivacy privacy) {
+    std::size_t key = std::hash<std::string>()(author->getUsername());
+    key = key * 31 + std::hash<std::string>()(timestamp);
+    key = key * 31 + std::hash<std::string>()(content);
+    auto range = loadedPostKeys.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+        Post* existing = it->second;
+        if (existing->getUser() == author && existing->getTimestamp() == timestamp &&
+            existing->getContent() == content) {
+            // Older builds re-saved every post on each restart; keep the first copy
+            // and let the duplicate's id resolve to it
+            if (savedId >= 0) loadedPostIds.emplace(savedId, existing);
+            ++droppedDuplicatePosts;
+            return existing;
+        }
+    }
+
+    Post* post = storePost(savedId >= 0 && !posts.contains(savedId)
+        ? std::make_unique<Post>(savedId, author, content, timestamp, privacy)
+        : std::make_unique<Post>(author, content, timestamp, privacy));
+    if (!post) return nullptr;
+    loadedPostKeys.emplace(key, post);
+    if (savedId >= 0) loadedPostIds.emplace(savedId, post);
+    return post;
+}
+
+void FacebookSystem::forgetLoadedPost(Post* post) {
+    for (auto it = loadedPostIds.begin(); it != loadedPostIds.end();) {
+        it = it->second == post ? loadedPostIds.erase(it) : std::next(it);
+    }
+    for (auto it = loadedPostKeys.begin(); it != loadedPostKeys.end();) {
+        it = it->second == post ? loadedPostKeys.erase(it) : std::next(it);
+    }
+}
+
+void FacebookSystem::unstorePost(Post* post) {
+    // Destroyed when this returns, after every other reference is unlinked
+    std::unique_ptr<Post> owned = posts.removePost(post);
+    if (!owned) return;
+    logMutation({"POST_DELETE", std::to_string(post->getId())});
+    postsRemovedAt = Versioned::tick();
+    searchIndex.removePost(post);
+    post->getUser()->removePost(post);
+}
+
 void FacebookSystem::createPost(const std::string& content) {
     if (!currentUser) return;
     time_t now = time(0);
-    Post* post = new Post(currentUser, content, std::to_string(now));
-    posts.push_back(post);
-    currentUser->addPost(post);
+    storePost(std::make_unique<Post>(currentUser, content, std::to_string(now)));
 }
 
 Post* FacebookSystem::createPost(const std::string& content, User* author) {
     if (!author) return nullptr;
     time_t now = time(0);
-    Post* post = new Post(author, content, std::to_string(now));
-    posts.push_back(post);
-    author->addPost(post);
-    return post;
+    return storePost(std::make_unique<Post>(author, content, std::to_string(now)));
 }
 
 void FacebookSystem::likePost(Post* post) {
     if (!currentUser || !post) return;
-    post->addLike(currentUser->getUsername());
+    post->addLike(currentUser->getId());
+    logMutation({"LIKE", std::to_string(post->getId()), currentUser->getUsername()});
     User* author = findUserByUsername(post->getUser()->getUsername());
     if (author) {
         addNotification(author, currentUser->getUsername() + " liked your post");
@@ -624,21 +802,14 @@ void FacebookSystem::likePost(Post* post) {
 }
 
 void FacebookSystem::likePost(int postId) {
-    if (!currentUser || postId < 0 || postId >= posts.size()) return;
-    Post* post = posts[postId];
-    likePost(post);
+    if (!currentUser) return;
+    likePost(posts.findById(postId));
 }
 
 void FacebookSystem::commentOnPost(int postId, const std::string& comment) {
     if (!currentUser) return;
     
-    Post* post = nullptr;
-    for (auto* p : posts) {
-        if (p->getId() == postId) {
-            post = p;
-            break;
-        }
-    }
+    Post* post = posts.findById(postId);
     if (!post) return;
     
     post->addComment(currentUser, comment);
@@ -651,13 +822,7 @@ void FacebookSystem::commentOnPost(int postId, const std::string& comment) {
 void FacebookSystem::sharePost(int postId) {
     if (!currentUser) return;
     
-    Post* originalPost = nullptr;
-    for (auto* post : posts) {
-        if (post->getId() == postId) {
-            originalPost = post;
-            break;
-        }
-    }
+    Post* originalPost = posts.findById(postId);
     if (!originalPost) return;
     
     std::string newContent = "Shared: " + originalPost->getContent();
@@ -669,53 +834,119 @@ void FacebookSystem::sharePost(int postId) {
     }
 }
 
+bool FacebookSystem::deletePost(int postId) {
+    if (!currentUser) return false;
+    
+    Post* post = posts.findById(postId);
+    if (!post || post->getUser() != currentUser) return false;
+    
+    unstorePost(post);
+    return true;
+}
+
 std::vector<Post*> FacebookSystem::searchPosts(const std::string& query) const {
-    std::vector<Post*> results;
-    std::string lowerQuery = query;
-    std::transform(lowerQuery.begin(), lowerQuery.end(), lowerQuery.begin(), ::tolower);
+    if (query.find_first_not_of(" \t") == std::string::npos) {
+        return posts.getPosts();
+    }
     
-    for (const auto& post : posts) {
-        std::string content = post->getContent();
-        std::transform(content.begin(), content.end(), content.begin(), ::tolower);
-        
-        if (content.find(lowerQuery) != std::string::npos ||
-            post->getUser()->getUsername().find(query) != std::string::npos) {
+    std::vector<Post*> results;
+    for (int postId : searchIndex.search(query)) {
+        if (Post* post = posts.findById(postId)) {
             results.push_back(post);
         }
     }
     
-    return results;
-}
-
-std::vector<User*> FacebookSystem::searchUsers(const std::string& query) const {
-    std::vector<User*> results;
-    for (const auto& user : users) {
-        if (user->getUsername().find(query) != std::string::npos ||
-            user->getEmail().find(query) != std::string::npos) {
-            results.push_back(user);
+    // A query naming a user also returns that user's posts
+    if (User* author = findUserByUsername(query)) {
+        std::unordered_set<int> found;
+        found.reserve(results.size());
+        for (const Post* post : results) {
+            found.insert(post->getId());
+        }
+        for (Post* post : author->getPosts()) {
+            if (found.insert(post->getId()).second) {
+                results.push_back(post);
+            }
         }
     }
+    
     return results;
 }
 
+std::vector<Post*> FacebookSystem::getPostsBetween(std::int64_t fromEpoch, std::int64_t toEpoch) const {
+    // Anonymous viewers only see public posts, which the scan filters alone
+    if (!currentUser) return posts.postsBetween(fromEpoch, toEpoch, PostPrivacy::PUBLIC);
+
+    std::vector<Post*> visible = posts.postsBetween(fromEpoch, toEpoch, PostPrivacy::PRIVATE);
+    visible.erase(std::remove_if(visible.begin(), visible.end(),
+                                 [this](const Post* post) { return !FeedService::isVisible(*post, *currentUser); }),
+                  visible.end());
+    return visible;
+}
+
+std::vector<User*> FacebookSystem::searchUsers(const std::string& query, std::size_t limit) const {
+    return users.search(query, limit);
+}
+
 void FacebookSystem::sendMessage(const std::string& to, const std::string& message) {
     if (!currentUser) return;
     
     User* toUser = findUserByUsername(to);
     if (!toUser) return;
     
-    std::string chatKey = createChatKey(currentUser->getUsername(), to);
-    conversations[chatKey].push_back({currentUser->getUsername(), message});
+    openConversation(to);
+    // One append to the archive makes the message durable
+    std::string timestamp = getCurrentTimestamp();
+    archive.append(currentUser->getUsername(), to, timestamp, message);
+    archive.sync();
+    conversations.append(currentUser->getId(), toUser->getId(), Timestamp::toEpoch(timestamp), message);
 }
 
-std::vector<std::pair<std::string, std::string>> FacebookSystem::getMessages(const std::string& withUsername) const {
+void FacebookSystem::openConversation(const std::string& other) {
+    UserId otherId = User::findId(other);
+    if (otherId == INVALID_USER_ID || conversations.find(currentUser->getId(), otherId)) return;
+
+    archive.read(currentUser->getUsername(), other, [this](const StorageEngine::MessageRow& row) {
+        loadKey.assign(row.from);
+        UserId from = User::idOf(loadKey);
+        loadKey.assign(row.to);
+        UserId to = User::idOf(loadKey);
+        loadKey.assign(row.timestamp);
+        conversations.append(from, to, Timestamp::toEpoch(loadKey), row.text);
+    });
+}
+
+MessageRange FacebookSystem::getMessages(const std::string& withUsername) {
     if (!currentUser) return {};
     
-    std::string chatKey = createChatKey(currentUser->getUsername(), withUsername);
-    if (conversations.find(chatKey) != conversations.end()) {
-        return conversations.at(chatKey);
-    }
-    return {};
+    UserId withId = User::findId(withUsername);
+    if (withId == INVALID_USER_ID) return {};
+    openConversation(withUsername);
+    return conversations.messagesBetween(currentUser->getId(), withId);
+}
+
+MessagePage FacebookSystem::getMessages(const std::string& withUsername, const MessageCursor& before,
+                                        std::size_t limit) {
+    if (!currentUser) return {};
+
+    UserId withId = User::findId(withUsername);
+    if (withId == INVALID_USER_ID) return {};
+    openConversation(withUsername);
+    return conversations.page(currentUser->getId(), withId, before, limit);
+}
+
+std::vector<MessageArchive::InboxEntry> FacebookSystem::getInbox(std::size_t limit) const {
+    if (!currentUser) return {};
+    return archive.inboxOf(currentUser->getUsername(), limit);
+}
+
+std::size_t FacebookSystem::getUnreadMessageCount() const {
+    return currentUser ? archive.unreadCount(currentUser->getUsername()) : 0;
+}
+
+void FacebookSystem::markConversationRead(const std::string& withUsername) {
+    if (!currentUser) return;
+    archive.markRead(currentUser->getUsername(), withUsername);
 }
 
 void FacebookSystem::removeFriend(const std::string& username) {
@@ -725,11 +956,12 @@ void FacebookSystem::removeFriend(const std::string& username) {
     if (!otherUser) return;
     
     // Remove from each other's friends list
-    currentUser->removeFriend(username);
-    otherUser->removeFriend(currentUser->getUsername());
+    currentUser->removeFriend(otherUser->getId());
+    otherUser->removeFriend(currentUser->getId());
+    timelines.invalidate(currentUser->getId());
+    timelines.invalidate(otherUser->getId());
     
-    // Save changes
-    saveFriends();
+    logMutation({"FRIEND_REMOVE", currentUser->getUsername(), otherUser->getUsername()});
 }
 
 void FacebookSystem::addNotification(User* user, const std::string& message) {
@@ -739,10 +971,6 @@ void FacebookSystem::addNotification(User* user, const std::string& message) {
     }
 }
 
-std::string FacebookSystem::createChatKey(const std::string& user1, const std::string& user2) const {
-    return user1 < user2 ? user1 + "_" + user2 : user2 + "_" + user1;
-}
-
 void FacebookSystem::clearNotifications() {
     if (!currentUser) return;
     
@@ -753,21 +981,11 @@ void FacebookSystem::clearNotifications() {
 }
 
 User* FacebookSystem::findUserByUsername(const std::string& username) const {
-    for (auto* user : users) {
-        if (user->getUsername() == username) {
-            return user;
-        }
-    }
-    return nullptr;
+    return users.findByUsername(username);
 }
 
 User* FacebookSystem::findUserByEmail(const std::string& email) const {
-    for (auto* user : users) {
-        if (user->getEmail() == email) {
-            return user;
-        }
-    }
-    return nullptr;
+    return users.findByEmail(email);
 }
 
 Post* FacebookSystem::createPost(const std::string& content, PostPrivacy privacy) {
@@ -778,9 +996,7 @@ Post* FacebookSystem::createPost(const std::string& content, PostPrivacy privacy
     std::string timestamp = std::ctime(&now_c);
     timestamp.pop_back(); // Remove trailing newline
 
-    Post* post = new Post(currentUser, content, timestamp, privacy);
-    posts.push_back(post);
-    return post;
+    return storePost(std::make_unique<Post>(currentUser, content, timestamp, privacy));
 }
 
 std::vector<std::string> FacebookSystem::getNotifications() const {
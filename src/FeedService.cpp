@@ -0,0 +1,106 @@
+#include "../include/FeedService.h"
+#include "../include/UserDirectory.h"
+#include "../include/User.h"
+#include "../include/Post.h"
+#include <queue>
+#include <algorithm>
+
+namespace {
+
+// One author's posts, walked from newest to oldest
+struct FeedSource {
+    const std::vector<Post*>* posts;
+    std::size_t remaining;  // posts[0, remaining) are still unread
+    // Order key of head(), cached so heap comparisons do not dereference posts
+    std::int64_t epoch = 0;
+    int postId = 0;
+
+    Post* head() const { return (*posts)[remaining - 1]; }
+    void loadKey() {
+        epoch = head()->getEpoch();
+        postId = head()->getId();
+    }
+};
+
+// Same order as Post::olderThan, on the cached keys
+struct NewerFirst {
+    bool operator()(const FeedSource& a, const FeedSource& b) const {
+        return a.epoch != b.epoch ? a.epoch < b.epoch : a.postId < b.postId;
+    }
+};
+
+}
+
+std::vector<const User*> FeedService::collectAuthors(const User& viewer) const {
+    std::vector<const User*> authors;
+    authors.reserve(viewer.getFriendIds().size() + 1);
+    authors.push_back(&viewer);
+
+    for (UserId friendId : viewer.getFriendIds()) {
+        const User* author = directory.findById(friendId);
+        if (!author || author == &viewer) continue;
+        // Blocking hides every post, so drop the whole author up front
+        if (viewer.isBlocked(author->getId()) || author->isBlocked(viewer.getId())) continue;
+        authors.push_back(author);
+    }
+    return authors;
+}
+
+bool FeedService::isVisible(const Post& post, const User& viewer) {
+    const User* author = post.getUser();
+    if (!author) return false;
+    if (author == &viewer) return true;
+    if (viewer.isBlocked(author->getId()) || author->isBlocked(viewer.getId())) return false;
+    if (post.getPrivacy() == PostPrivacy::FRIENDS_ONLY && author->isRestrictedFriend(viewer.getId())) {
+        return false;
+    }
+    return post.canUserView(&viewer);
+}
+
+FeedPage FeedService::getFeed(const User& viewer, const FeedCursor& cursor, std::size_t pageSize) const {
+    return mergeAuthors(viewer, collectAuthors(viewer), cursor, pageSize);
+}
+
+FeedPage FeedService::mergeAuthors(const User& viewer, const std::vector<const User*>& authors,
+                                   const FeedCursor& cursor, std::size_t pageSize) const {
+    FeedPage page;
+    page.next = cursor;
+    if (pageSize == 0) return page;
+
+    std::priority_queue<FeedSource, std::vector<FeedSource>, NewerFirst> heap;
+    for (const User* author : authors) {
+        const auto& posts = author->getPosts();
+        // Skip everything at or after the cursor
+        std::size_t remaining = posts.size();
+        if (!cursor.atStart()) {
+            auto it = std::partition_point(posts.begin(), posts.end(),
+                [&](const Post* post) { return cursor.precedes(post->getEpoch(), post->getId()); });
+            remaining = static_cast<std::size_t>(it - posts.begin());
+        }
+        if (remaining > 0) {
+            FeedSource source{&posts, remaining};
+            source.loadKey();
+            heap.push(source);
+        }
+    }
+
+    page.posts.reserve(pageSize);
+    while (!heap.empty() && page.posts.size() < pageSize) {
+        FeedSource source = heap.top();
+        heap.pop();
+
+        Post* post = source.head();
+        page.next.epoch = source.epoch;
+        page.next.postId = source.postId;
+        if (isVisible(*post, viewer)) {
+            page.posts.push_back(post);
+        }
+
+        if (--source.remaining > 0) {
+            source.loadKey();
+            heap.push(source);
+        }
+    }
+    page.hasMore = !heap.empty();
+    return page;
+}
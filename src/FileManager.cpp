@@ -1,235 +1,160 @@
 #include "../include/FileManager.h"
-#include <filesystem>
 #include <iostream>
 #include <iomanip>
-#include <set>
 
+const std::string FileManager::DATA_DIR = "../data";
 const std::string FileManager::USERS_FILE = "../data/users.txt";
 const std::string FileManager::POSTS_FILE = "../data/posts.txt";
 const std::string FileManager::FRIENDS_FILE = "../data/friends.txt";
 
-std::vector<std::string> FileManager::readLines(const std::string& filename) {
-    std::vector<std::string> lines;
-    try {
-        std::filesystem::path filePath(filename);
-        std::filesystem::create_directories(filePath.parent_path());
-
-        std::cout << std::setw(15) << std::left << "[File]" << "Reading: " << filename << std::endl;
-        std::ifstream file(filename);
-        if (!file.is_open()) {
-            std::cout << std::setw(15) << std::left << "[Error]" << "Failed to open: " << filename << std::endl;
-            throw FileOperationException();
-        }
-        std::string line;
-        while (std::getline(file, line)) {
-            if (!line.empty()) {
-                lines.push_back(line);
-            }
-        }
-        file.close();
-        std::cout << std::setw(15) << std::left << "[Success]" << "Read " << lines.size() << " lines from " << filename << std::endl;
-    } catch (const std::exception& e) {
-        std::cout << std::setw(15) << std::left << "[Error]" << "Exception: " << e.what() << std::endl;
-        throw FileOperationException();
+namespace {
+
+using Conversations = std::map<std::string, std::vector<std::pair<std::string, std::string>>>;
+
+// Builds plain containers from loaded records
+class ContainerSink : public StorageEngine::Sink {
+private:
+    const UserDirectory* lookup;
+    UserDirectory* users;
+    std::vector<Post*>* posts;
+    Conversations* conversations;
+    std::string key;
+
+    User* find(std::string_view username) {
+        key.assign(username);
+        return lookup->findByUsername(key);
     }
-    return lines;
-}
 
-void FileManager::writeLines(const std::string& filename, const std::vector<std::string>& lines) {
-    try {
-        std::filesystem::path filePath(filename);
-        std::filesystem::create_directories(filePath.parent_path());
-
-        std::cout << std::setw(15) << std::left << "[File]" << "Writing to: " << filename << std::endl;
-        std::ofstream file(filename);
-        if (!file.is_open()) {
-            std::cout << std::setw(15) << std::left << "[Error]" << "Failed to open for writing: " << filename << std::endl;
-            throw FileOperationException();
+public:
+    ContainerSink(const UserDirectory& lookup, UserDirectory* users = nullptr,
+                  std::vector<Post*>* posts = nullptr, Conversations* conversations = nullptr)
+        : lookup(&lookup), users(users), posts(posts), conversations(conversations) {}
+
+    void user(const StorageEngine::UserRow& row) override {
+        User* user = new User(std::string(row.username), std::string(row.email),
+                              std::string(row.password), std::string(row.gender));
+        user->setBot(row.flags & StorageEngine::USER_BOT);
+        user->setPublic(row.flags & StorageEngine::USER_PUBLIC);
+        if (!users->addUser(user)) {
+            delete user;
         }
-        for (const auto& line : lines) {
-            file << line << std::endl;
+    }
+
+    void post(const StorageEngine::PostRow& row) override {
+        User* author = find(row.author);
+        if (!author) return;
+        std::string content(row.content), timestamp(row.timestamp);
+        Post* post = row.id >= 0 ? new Post(row.id, author, content, timestamp, row.privacy)
+                                 : new Post(author, content, timestamp, row.privacy);
+        posts->push_back(post);
+        author->addPost(post);
+    }
+
+    void friendship(const StorageEngine::FriendshipRow& row) override {
+        User* user1 = find(row.user1);
+        User* user2 = find(row.user2);
+        if (user1 && user2) {
+            user1->addFriend(user2->getId());
+            user2->addFriend(user1->getId());
         }
-        file.close();
-        std::cout << std::setw(15) << std::left << "[Success]" << "Wrote " << lines.size() << " lines to " << filename << std::endl;
-    } catch (const std::exception& e) {
-        std::cout << std::setw(15) << std::left << "[Error]" << "Exception: " << e.what() << std::endl;
+    }
+
+    void message(const StorageEngine::MessageRow& row) override {
+        std::string from(row.from);
+        (*conversations)[StorageEngine::chatKey(from, std::string(row.to))].push_back({from, std::string(row.text)});
+    }
+};
+
+void load(StorageEngine::Sink& sink, StorageEngine::Entity entity, const char* what) {
+    std::cout << "\n" << std::setw(15) << std::left << "[Loading]" << what << "..." << std::endl;
+    TextStorage storage(FileManager::DATA_DIR);
+    if (!storage.load(sink, entity)) {
+        std::cout << std::setw(15) << std::left << "[Error]" << "Failed to load " << what << std::endl;
         throw FileOperationException();
     }
 }
 
-void FileManager::loadUsers(std::vector<User*>& users) {
+}
+
+void FileManager::loadUsers(UserDirectory& users) {
+    ContainerSink sink(users, &users);
     try {
-        std::cout << "\n" << std::setw(15) << std::left << "[Loading]" << "Users..." << std::endl;
-        auto userLines = readLines(USERS_FILE);
-        for (const auto& line : userLines) {
-            std::vector<std::string> parts;
-            std::stringstream ss(line);
-            std::string part;
-            while (std::getline(ss, part, '|')) {
-                parts.push_back(part);
-            }
-            if (parts.size() >= 4) {
-                users.push_back(new User(
-                    parts[1], // username
-                    parts[0], // email
-                    parts[2], // password
-                    parts[3]  // gender
-                ));
-            }
-        }
-        std::cout << std::setw(15) << std::left << "[Success]" << "Loaded " << users.size() << " users" << std::endl;
-    } catch (const std::exception& e) {
-        for (auto user : users) delete user;
+        load(sink, StorageEngine::USERS, "Users");
+    } catch (const FileOperationException&) {
+        std::vector<User*> loaded = users.getUsers();
         users.clear();
-        std::cout << std::setw(15) << std::left << "[Error]" << "Failed to load users: " << e.what() << std::endl;
-        throw FileOperationException();
+        for (auto user : loaded) delete user;
+        throw;
     }
+    std::cout << std::setw(15) << std::left << "[Success]" << "Loaded " << users.size() << " users" << std::endl;
 }
 
-void FileManager::loadPosts(std::vector<User*>& users, std::vector<Post*>& posts) {
+void FileManager::loadPosts(const UserDirectory& users, std::vector<Post*>& posts) {
+    ContainerSink sink(users, nullptr, &posts);
     try {
-        std::cout << "\n" << std::setw(15) << std::left << "[Loading]" << "Posts..." << std::endl;
-        auto postLines = readLines(POSTS_FILE);
-        for (const auto& line : postLines) {
-            std::vector<std::string> parts;
-            std::stringstream ss(line);
-            std::string part;
-            while (std::getline(ss, part, '|')) {
-                parts.push_back(part);
-            }
-            if (parts.size() >= 4) {
-                User* author = nullptr;
-                for (auto user : users) {
-                    if (user->getUsername() == parts[0]) {
-                        author = user;
-                        break;
-                    }
-                }
-                if (author) {
-                    Post* newPost = new Post(
-                        author,
-                        parts[1], // content
-                        parts[2], // timestamp
-                        static_cast<PostPrivacy>(std::stoi(parts[3])) // privacy
-                    );
-                    posts.push_back(newPost);
-                    author->addPost(newPost);
-                }
-            }
-        }
-        std::cout << std::setw(15) << std::left << "[Success]" << "Loaded " << posts.size() << " posts" << std::endl;
-    } catch (const std::exception& e) {
+        load(sink, StorageEngine::POSTS, "Posts");
+    } catch (const FileOperationException&) {
         for (auto post : posts) delete post;
         posts.clear();
-        std::cout << std::setw(15) << std::left << "[Error]" << "Failed to load posts: " << e.what() << std::endl;
-        throw FileOperationException();
+        throw;
     }
+    std::cout << std::setw(15) << std::left << "[Success]" << "Loaded " << posts.size() << " posts" << std::endl;
 }
 
-void FileManager::loadFriendships(std::vector<User*>& users) {
-    try {
-        std::cout << "\n" << std::setw(15) << std::left << "[Loading]" << "Friendships..." << std::endl;
-        auto friendLines = readLines(FRIENDS_FILE);
-        for (const auto& line : friendLines) {
-            std::vector<std::string> parts;
-            std::stringstream ss(line);
-            std::string part;
-            while (std::getline(ss, part, '|')) {
-                parts.push_back(part);
-            }
-            if (parts.size() == 2) {
-                User* user1 = nullptr;
-                User* user2 = nullptr;
-                for (auto* user : users) {
-                    if (user->getUsername() == parts[0]) user1 = user;
-                    if (user->getUsername() == parts[1]) user2 = user;
-                }
-                if (user1 && user2) {
-                    user1->addFriend(user2->getUsername());
-                    user2->addFriend(user1->getUsername());
-                }
+void FileManager::loadFriendships(const UserDirectory& users) {
+    ContainerSink sink(users);
+    load(sink, StorageEngine::FRIENDSHIPS, "Friendships");
+    std::cout << std::setw(15) << std::left << "[Success]" << "Loaded friendships" << std::endl;
+}
+
+void FileManager::loadConversations(Conversations& conversations) {
+    UserDirectory none;
+    ContainerSink sink(none, nullptr, nullptr, &conversations);
+    load(sink, StorageEngine::MESSAGES, "Conversations");
+    std::cout << std::setw(15) << std::left << "[Success]" << "Loaded " << conversations.size() << " conversations" << std::endl;
+}
+
+void FileManager::save(const std::vector<User*>* users, const std::vector<Post*>* posts,
+                       const Conversations* conversations, unsigned entities) {
+    std::vector<StorageEngine::MessageRow> messages;
+    if (conversations) {
+        for (const auto& [key, chat] : *conversations) {
+            for (const auto& [from, text] : chat) {
+                messages.push_back({from, StorageEngine::chatPeer(key, from), {}, text});
             }
         }
-        std::cout << std::setw(15) << std::left << "[Success]" << "Loaded friendships" << std::endl;
-    } catch (const std::exception& e) {
-        std::cout << std::setw(15) << std::left << "[Error]" << "Failed to load friendships: " << e.what() << std::endl;
+    }
+
+    StorageEngine::Dataset data;
+    data.users = users;
+    data.posts = posts;
+    data.messages = &messages;
+    data.entities = entities;
+    TextStorage storage(DATA_DIR);
+    if (!storage.save(data)) {
         throw FileOperationException();
     }
 }
 
 void FileManager::saveUsers(const std::vector<User*>& users) {
-    try {
-        std::cout << "\n" << std::setw(15) << std::left << "[Saving]" << "Users..." << std::endl;
-        std::vector<std::string> userLines;
-        for (const auto& user : users) {
-            userLines.push_back(
-                user->getUsername() + "|" +
-                user->getEmail() + "|" +
-                user->getPassword() + "|" +
-                user->getGender()
-            );
-        }
-        writeLines(USERS_FILE, userLines);
-        std::cout << std::setw(15) << std::left << "[Success]" << "Saved " << users.size() << " users" << std::endl;
-    } catch (const std::exception& e) {
-        std::cout << std::setw(15) << std::left << "[Error]" << "Failed to save users: " << e.what() << std::endl;
-        throw FileOperationException();
-    }
+    save(&users, nullptr, nullptr, StorageEngine::USERS);
 }
 
 void FileManager::savePosts(const std::vector<Post*>& posts) {
-    try {
-        std::cout << "\n" << std::setw(15) << std::left << "[Saving]" << "Posts..." << std::endl;
-        std::vector<std::string> postLines;
-        for (const auto& post : posts) {
-            postLines.push_back(
-                post->getUser()->getUsername() + "|" +
-                post->getContent() + "|" +
-                post->getTimestamp() + "|" +
-                std::to_string(static_cast<int>(post->getPrivacy()))
-            );
-        }
-        writeLines(POSTS_FILE, postLines);
-        std::cout << std::setw(15) << std::left << "[Success]" << "Saved " << posts.size() << " posts" << std::endl;
-    } catch (const std::exception& e) {
-        std::cout << std::setw(15) << std::left << "[Error]" << "Failed to save posts: " << e.what() << std::endl;
-        throw FileOperationException();
-    }
+    save(nullptr, &posts, nullptr, StorageEngine::POSTS);
 }
 
 void FileManager::saveFriendships(const std::vector<User*>& users) {
-    try {
-        std::cout << "\n" << std::setw(15) << std::left << "[Saving]" << "Friendships..." << std::endl;
-        std::vector<std::string> friendLines;
-        std::set<std::string> processedPairs; // To avoid duplicates
-        
-        for (const auto* user : users) {
-            for (const auto& friendUsername : user->getFriends()) {
-                std::string pair1 = user->getUsername() + "|" + friendUsername;
-                std::string pair2 = friendUsername + "|" + user->getUsername();
-                
-                // Only save one direction of the friendship
-                if (user->getUsername() < friendUsername && 
-                    processedPairs.find(pair1) == processedPairs.end() &&
-                    processedPairs.find(pair2) == processedPairs.end()) {
-                    friendLines.push_back(pair1);
-                    processedPairs.insert(pair1);
-                    processedPairs.insert(pair2);
-                }
-            }
-        }
-        
-        writeLines(FRIENDS_FILE, friendLines);
-        std::cout << std::setw(15) << std::left << "[Success]" << "Saved " << friendLines.size() << " friendships" << std::endl;
-    } catch (const std::exception& e) {
-        std::cout << std::setw(15) << std::left << "[Error]" << "Failed to save friendships: " << e.what() << std::endl;
-        throw FileOperationException();
-    }
+    save(&users, nullptr, nullptr, StorageEngine::FRIENDSHIPS);
+}
+
+void FileManager::saveConversations(const Conversations& conversations) {
+    save(nullptr, nullptr, &conversations, StorageEngine::MESSAGES);
 }
 
-void FileManager::loadData(std::vector<User*>& users,
+void FileManager::loadData(UserDirectory& users,
                          std::vector<Post*>& posts,
-                         std::map<std::string, std::vector<std::pair<std::string, std::string>>>& conversations) {
+                         Conversations& conversations) {
     loadUsers(users);
     loadPosts(users, posts);
     loadFriendships(users);
@@ -238,17 +163,7 @@ void FileManager::loadData(std::vector<User*>& users,
 
 void FileManager::saveData(const std::vector<User*>& users,
                          const std::vector<Post*>& posts,
-                         const std::map<std::string, std::vector<std::pair<std::string, std::string>>>& conversations) {
-    saveUsers(users);
-    savePosts(posts);
-    saveFriendships(users);
-    saveConversations(conversations);
-}
-
-void FileManager::loadConversations(std::map<std::string, std::vector<std::pair<std::string, std::string>>>& conversations) {
-    // TO DO: implement loadConversations
-}
-
-void FileManager::saveConversations(const std::map<std::string, std::vector<std::pair<std::string, std::string>>>& conversations) {
-    // TO DO: implement saveConversations
+                         const Conversations& conversations) {
+    save(&users, &posts, &conversations,
+         StorageEngine::USERS | StorageEngine::POSTS | StorageEngine::FRIENDSHIPS | StorageEngine::MESSAGES);
 }
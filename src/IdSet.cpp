@@ -0,0 +1,123 @@
+#include "../include/IdSet.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define IDSET_USE_SSE2 1
+#endif
+
+namespace {
+
+// When one side is this many times larger, probing it with binary search
+// beats walking both lists
+constexpr std::size_t GALLOP_RATIO = 32;
+
+std::size_t intersectScalar(const UserId* a, std::size_t aSize,
+                            const UserId* b, std::size_t bSize,
+                            std::vector<UserId>* out) {
+    std::size_t i = 0, j = 0, count = 0;
+    while (i < aSize && j < bSize) {
+        if (a[i] < b[j]) {
+            ++i;
+        } else if (b[j] < a[i]) {
+            ++j;
+        } else {
+            if (out) out->push_back(a[i]);
+            ++count;
+            ++i;
+            ++j;
+        }
+    }
+    return count;
+}
+
+std::size_t intersectGalloping(const UserId* small, std::size_t smallSize,
+                               const UserId* large, std::size_t largeSize,
+                               std::vector<UserId>* out) {
+    std::size_t count = 0;
+    const UserId* lo = large;
+    const UserId* end = large + largeSize;
+    for (std::size_t i = 0; i < smallSize && lo != end; ++i) {
+        // Exponential search from the last position, then binary search the bracket
+        std::size_t step = 1;
+        const UserId* hi = lo;
+        while (hi < end && *hi < small[i]) {
+            lo = hi;
+            hi = (static_cast<std::size_t>(end - hi) > step) ? hi + step : end;
+            step <<= 1;
+        }
+        lo = std::lower_bound(lo, hi, small[i]);
+        if (lo != end && *lo == small[i]) {
+            if (out) out->push_back(small[i]);
+            ++count;
+            ++lo;
+        }
+    }
+    return count;
+}
+
+#ifdef IDSET_USE_SSE2
+// Block-wise all-pairs compare of 4x4 ids (Schlegel et al.). Each equal pair
+// lives in exactly one (a-block, b-block) combination, so output stays sorted
+// and duplicate-free.
+std::size_t intersectSSE2(const UserId* a, std::size_t aSize,
+                          const UserId* b, std::size_t bSize,
+                          std::vector<UserId>* out) {
+    std::size_t i = 0, j = 0, count = 0;
+    const std::size_t aBlocks = aSize & ~static_cast<std::size_t>(3);
+    const std::size_t bBlocks = bSize & ~static_cast<std::size_t>(3);
+
+    while (i < aBlocks && j < bBlocks) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+
+        __m128i eq = _mm_cmpeq_epi32(va, vb);
+        vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        eq = _mm_or_si128(eq, _mm_cmpeq_epi32(va, vb));
+        vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        eq = _mm_or_si128(eq, _mm_cmpeq_epi32(va, vb));
+        vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        eq = _mm_or_si128(eq, _mm_cmpeq_epi32(va, vb));
+
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+        if (mask) {
+            for (int k = 0; k < 4; ++k) {
+                if (mask & (1 << k)) {
+                    if (out) out->push_back(a[i + k]);
+                    ++count;
+                }
+            }
+        }
+
+        const UserId aMax = a[i + 3];
+        const UserId bMax = b[j + 3];
+        if (aMax <= bMax) i += 4;
+        if (bMax <= aMax) j += 4;
+    }
+
+    return count + intersectScalar(a + i, aSize - i, b + j, bSize - j, out);
+}
+#endif
+
+}
+
+std::size_t IdSet::intersect(const UserId* a, std::size_t aSize,
+                             const UserId* b, std::size_t bSize,
+                             std::vector<UserId>* out) {
+    if (aSize == 0 || bSize == 0) return 0;
+    if (aSize > bSize) {
+        std::swap(a, b);
+        std::swap(aSize, bSize);
+    }
+    if (bSize / aSize >= GALLOP_RATIO) {
+        return intersectGalloping(a, aSize, b, bSize, out);
+    }
+#ifdef IDSET_USE_SSE2
+    return intersectSSE2(a, aSize, b, bSize, out);
+#else
+    return intersectScalar(a, aSize, b, bSize, out);
+#endif
+}
+
+std::size_t IdSet::intersect(const IdSet& a, const IdSet& b, std::vector<UserId>* out) {
+    return intersect(a.ids.data(), a.ids.size(), b.ids.data(), b.ids.size(), out);
+}
@@ -0,0 +1,387 @@
+#include "../include/MessageArchive.h"
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <iterator>
+#include "../include/AtomicFile.h"
+#include "../include/Timestamp.h"
+#include "../include/WriteAheadLog.h"
+
+namespace {
+
+const std::vector<MessageArchive::Segment> NO_SEGMENTS;
+
+// FNV-1a, so bucket numbers do not depend on the standard library's hash
+std::size_t bucketOf(std::string_view key) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char c : key) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    return static_cast<std::size_t>(hash % MessageArchive::BUCKET_COUNT);
+}
+
+bool parseNumber(std::string_view field, std::uint64_t& value) {
+    auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+    return result.ec == std::errc() && result.ptr == field.data() + field.size();
+}
+
+}
+
+MessageArchive::MessageArchive(std::string directory) : directory(std::move(directory)) {}
+
+MessageArchive::~MessageArchive() {
+    closeFiles();
+}
+
+std::string MessageArchive::pairKey(std::string_view a, std::string_view b) {
+    if (b < a) std::swap(a, b);
+    std::string key;
+    key.reserve(a.size() + b.size() + 1);
+    key.append(a).append(1, '\0').append(b);
+    return key;
+}
+
+std::string MessageArchive::bucketPath(std::size_t bucket) const {
+    return directory + "/" + std::to_string(bucket) + ".log";
+}
+
+MessageArchive::Conversation& MessageArchive::conversation(std::string_view a, std::string_view b) {
+    std::string key = pairKey(a, b);
+    auto it = conversations.find(key);
+    if (it != conversations.end()) return it->second;
+
+    Conversation& added = conversations[key];
+    added.low = std::string(a < b ? a : b);
+    added.high = std::string(a < b ? b : a);
+    added.bucket = static_cast<std::uint32_t>(bucketOf(key));
+    inboxes[added.low].push_back(&added);
+    if (added.low != added.high) inboxes[added.high].push_back(&added);
+    return added;
+}
+
+void MessageArchive::addRecord(std::size_t bucket, const std::string& from, const std::string& to,
+                               const std::string& timestamp, const std::string& text,
+                               std::uint64_t offset, std::uint64_t length) {
+    Conversation& chat = conversation(from, to);
+    if (chat.bucket != bucket) return;  // not written by this archive
+    if (!chat.segments.empty() && chat.segments.back().offset + chat.segments.back().length == offset) {
+        chat.segments.back().length += length;
+        ++chat.segments.back().count;
+    } else {
+        chat.segments.push_back({offset, length, 1});
+    }
+    ++chat.messages;
+    ++messages;
+
+    chat.lastEpoch = Timestamp::toEpoch(timestamp);
+    chat.lastFrom = from;
+    chat.preview = previewOf(text);
+    // Sending does not read what the peer sent before; it only keeps a sender
+    // who was caught up from falling behind on their own message
+    if (chat.readBy(from) == chat.messages - 1) ++chat.readBy(from);
+}
+
+bool MessageArchive::open() {
+    closeFiles();
+    conversations.clear();
+    inboxes.clear();
+    bucketBytes.fill(0);
+    messages = 0;
+    exists = false;
+    indexStale = false;
+    if (!readIndex()) return false;
+
+    for (std::size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        std::error_code ec;
+        std::uint64_t size = std::filesystem::file_size(bucketPath(bucket), ec);
+        if (ec) size = 0;
+        if (size == bucketBytes[bucket]) continue;
+
+        indexStale = true;
+        if (size < bucketBytes[bucket]) {
+            // The bucket lost records the index knows about; index it afresh
+            for (auto& [key, chat] : conversations) {
+                if (chat.bucket != bucket) continue;
+                messages -= chat.messages;
+                chat.messages = 0;
+                chat.segments.clear();
+            }
+            scanBucket(bucket, 0);
+        } else {
+            scanBucket(bucket, bucketBytes[bucket]);
+        }
+    }
+    exists = true;
+    return true;
+}
+
+bool MessageArchive::readIndex() {
+    std::ifstream in(indexPath(), std::ios::binary);
+    if (!in.is_open()) return false;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        WriteAheadLog::Record record = WriteAheadLog::decode(line);
+        std::uint64_t bucket = 0, offset = 0, length = 0, count = 0, lowRead = 0, highRead = 0;
+        if (record[0] == "C" && record.size() == 8 && parseNumber(record[6], lowRead) &&
+            parseNumber(record[7], highRead)) {
+            Conversation& chat = conversation(record[1], record[2]);
+            chat.lastEpoch = Timestamp::toEpoch(record[3]);
+            chat.lastFrom = record[4];
+            chat.preview = record[5];
+            chat.lowRead = lowRead;
+            chat.highRead = highRead;
+        } else if (record[0] == "B" && record.size() == 3 && parseNumber(record[1], bucket) &&
+                   bucket < BUCKET_COUNT && parseNumber(record[2], length)) {
+            bucketBytes[bucket] = length;
+        } else if (record[0] == "S" && record.size() == 6 && parseNumber(record[3], offset) &&
+                   parseNumber(record[4], length) && parseNumber(record[5], count)) {
+            Conversation& chat = conversation(record[1], record[2]);
+            chat.segments.push_back({offset, length, static_cast<std::uint32_t>(count)});
+            chat.messages += count;
+            messages += count;
+        }
+    }
+    return true;
+}
+
+void MessageArchive::scanBucket(std::size_t bucket, std::uint64_t offset) {
+    std::string path = bucketPath(bucket);
+    std::ifstream in(path, std::ios::binary);
+    bucketBytes[bucket] = offset;
+    if (!in.is_open()) return;
+    in.seekg(static_cast<std::streamoff>(offset));
+    std::string tail((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    std::size_t start = 0;
+    while (start < tail.size()) {
+        std::size_t end = tail.find('\n', start);
+        if (end == std::string::npos) {
+            // Torn final record from a crash: drop it so appends start on a fresh line
+            std::error_code ec;
+            std::filesystem::resize_file(path, offset + start, ec);
+            break;
+        }
+        WriteAheadLog::Record record = WriteAheadLog::decode(tail.substr(start, end - start));
+        if (record.size() == 4) {
+            addRecord(bucket, record[0], record[1], record[2], record[3], offset + start, end + 1 - start);
+        }
+        start = end + 1;
+        bucketBytes[bucket] = offset + start;
+    }
+}
+
+void MessageArchive::create() {
+    closeFiles();
+    conversations.clear();
+    inboxes.clear();
+    bucketBytes.fill(0);
+    messages = 0;
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    for (std::size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        std::filesystem::remove(bucketPath(bucket), ec);
+    }
+    std::filesystem::remove(indexPath(), ec);
+    exists = true;
+    indexStale = true;
+}
+
+void MessageArchive::append(std::string_view from, std::string_view to,
+                            std::string_view timestamp, std::string_view text) {
+    if (!exists) return;
+    std::size_t bucket = conversation(from, to).bucket;
+    if (!files[bucket]) {
+        files[bucket] = std::fopen(bucketPath(bucket).c_str(), "ab");
+        if (!files[bucket]) {
+            std::cout << std::setw(15) << std::left << "[Error]" << "Could not open " << bucketPath(bucket) << std::endl;
+            return;
+        }
+    }
+
+    WriteAheadLog::Record record{std::string(from), std::string(to), std::string(timestamp), std::string(text)};
+    std::string line = WriteAheadLog::encode(record);
+    line += '\n';
+    std::fwrite(line.data(), 1, line.size(), files[bucket]);
+    unsynced[bucket] = true;
+    addRecord(bucket, record[0], record[1], record[2], record[3], bucketBytes[bucket], line.size());
+    bucketBytes[bucket] += line.size();
+    indexStale = true;
+}
+
+void MessageArchive::sync() {
+    for (std::size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        if (!unsynced[bucket]) continue;
+        if (files[bucket]) AtomicFile::sync(files[bucket]);
+        unsynced[bucket] = false;
+    }
+}
+
+void MessageArchive::closeFiles() {
+    sync();
+    for (std::FILE*& file : files) {
+        if (!file) continue;
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+std::size_t MessageArchive::read(std::string_view a, std::string_view b,
+                                 const std::function<void(const StorageEngine::MessageRow&)>& visit) const {
+    auto it = conversations.find(pairKey(a, b));
+    if (it == conversations.end() || it->second.segments.empty()) return 0;
+    const Conversation& chat = it->second;
+    if (files[chat.bucket]) std::fflush(files[chat.bucket]);
+
+    std::ifstream in(bucketPath(chat.bucket), std::ios::binary);
+    if (!in.is_open()) return 0;
+
+    std::size_t visited = 0;
+    std::string bytes;
+    for (const Segment& segment : chat.segments) {
+        bytes.resize(segment.length);
+        in.seekg(static_cast<std::streamoff>(segment.offset));
+        if (!in.read(bytes.data(), static_cast<std::streamsize>(segment.length))) break;
+
+        std::size_t start = 0;
+        while (start < bytes.size()) {
+            std::size_t end = bytes.find('\n', start);
+            if (end == std::string::npos) end = bytes.size();
+            WriteAheadLog::Record record = WriteAheadLog::decode(bytes.substr(start, end - start));
+            if (record.size() == 4) {
+                visit({record[0], record[1], record[2], record[3]});
+                ++visited;
+            }
+            start = end + 1;
+        }
+    }
+    return visited;
+}
+
+std::size_t MessageArchive::messageCount(std::string_view a, std::string_view b) const {
+    auto it = conversations.find(pairKey(a, b));
+    return it != conversations.end() ? it->second.messages : 0;
+}
+
+bool MessageArchive::appendUnlessStored(std::string_view from, std::string_view to,
+                                        std::string_view timestamp, std::string_view text) {
+    if (!exists) return false;
+    std::string key = pairKey(from, to);
+    auto stored = replayMatches.find(key);
+    if (stored == replayMatches.end()) {
+        // Read before anything is replayed into the conversation, so only
+        // what the archive held beforehand can absorb a replayed record
+        stored = replayMatches.emplace(std::move(key), std::unordered_map<std::string, std::size_t>()).first;
+        read(from, to, [&](const StorageEngine::MessageRow& row) {
+            ++stored->second[WriteAheadLog::encode({std::string(row.from), std::string(row.to),
+                                                    std::string(row.timestamp), std::string(row.text)})];
+        });
+    }
+
+    auto match = stored->second.find(WriteAheadLog::encode(
+        {std::string(from), std::string(to), std::string(timestamp), std::string(text)}));
+    if (match != stored->second.end() && match->second > 0) {
+        --match->second;
+        return false;
+    }
+    append(from, to, timestamp, text);
+    return true;
+}
+
+const std::vector<MessageArchive::Segment>& MessageArchive::segmentsOf(std::string_view a, std::string_view b) const {
+    auto it = conversations.find(pairKey(a, b));
+    return it != conversations.end() ? it->second.segments : NO_SEGMENTS;
+}
+
+std::vector<MessageArchive::InboxEntry> MessageArchive::inboxOf(const std::string& username, std::size_t limit) const {
+    auto it = inboxes.find(username);
+    if (it == inboxes.end()) return {};
+
+    std::vector<const Conversation*> chats = it->second;
+    auto newerFirst = [](const Conversation* a, const Conversation* b) {
+        return a->lastEpoch != b->lastEpoch ? a->lastEpoch > b->lastEpoch : a->messages > b->messages;
+    };
+    if (limit == 0 || limit >= chats.size()) {
+        std::sort(chats.begin(), chats.end(), newerFirst);
+    } else {
+        std::partial_sort(chats.begin(), chats.begin() + limit, chats.end(), newerFirst);
+        chats.resize(limit);
+    }
+
+    std::vector<InboxEntry> entries;
+    entries.reserve(chats.size());
+    for (const Conversation* chat : chats) {
+        entries.push_back({chat->low == username ? chat->high : chat->low, chat->lastEpoch, chat->lastFrom,
+                           chat->preview, chat->messages, chat->unreadBy(username)});
+    }
+    return entries;
+}
+
+std::size_t MessageArchive::unreadCount(const std::string& username) const {
+    auto it = inboxes.find(username);
+    if (it == inboxes.end()) return 0;
+    std::size_t unread = 0;
+    for (const Conversation* chat : it->second) {
+        unread += chat->unreadBy(username);
+    }
+    return unread;
+}
+
+bool MessageArchive::markRead(const std::string& username, const std::string& peer) {
+    auto it = conversations.find(pairKey(username, peer));
+    if (it == conversations.end() || it->second.readBy(username) == it->second.messages) return false;
+    it->second.readBy(username) = it->second.messages;
+    indexStale = true;
+    return true;
+}
+
+std::string MessageArchive::previewOf(std::string_view text) {
+    std::size_t cut = text.size();
+    if (cut > PREVIEW_LENGTH) {
+        // Do not split a UTF-8 sequence
+        cut = PREVIEW_LENGTH;
+        while (cut > 0 && (static_cast<unsigned char>(text[cut]) & 0xC0) == 0x80) --cut;
+    }
+    std::string preview(text.substr(0, cut));
+    std::replace(preview.begin(), preview.end(), '\n', ' ');
+    if (cut < text.size()) preview += "...";
+    return preview;
+}
+
+StorageEngine::FileImage MessageArchive::encodeIndex() {
+    // The index may only cover bytes that reach the disk before it does
+    sync();
+    std::string bytes = "#schema 1\n";
+    for (std::size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        if (bucketBytes[bucket] == 0) continue;
+        bytes += WriteAheadLog::encode({"B", std::to_string(bucket), std::to_string(bucketBytes[bucket])});
+        bytes += '\n';
+    }
+    for (const auto& [key, chat] : conversations) {
+        bytes += WriteAheadLog::encode({"C", chat.low, chat.high, std::to_string(chat.lastEpoch), chat.lastFrom,
+                                        chat.preview, std::to_string(chat.lowRead), std::to_string(chat.highRead)});
+        bytes += '\n';
+        for (const Segment& segment : chat.segments) {
+            bytes += WriteAheadLog::encode({"S", chat.low, chat.high, std::to_string(segment.offset),
+                                            std::to_string(segment.length), std::to_string(segment.count)});
+            bytes += '\n';
+        }
+    }
+    indexStale = false;
+    return {indexPath(), std::move(bytes)};
+}
+
+bool MessageArchive::writeIndex() {
+    StorageEngine::FileImage image = encodeIndex();
+    if (!StorageEngine::commit({image})) {
+        indexStale = true;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,119 @@
+#include "../include/MutualFriends.h"
+#include "../include/User.h"
+#include "../include/UserDirectory.h"
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+using CountMap = std::unordered_map<UserId, std::uint32_t>;
+
+void countFriendsOfFriends(const std::vector<const User*>& friends, std::size_t begin,
+                           std::size_t end, CountMap& counts) {
+    for (std::size_t i = begin; i < end; ++i) {
+        for (UserId candidate : friends[i]->getFriendIds()) {
+            ++counts[candidate];
+        }
+    }
+}
+
+}
+
+std::vector<UserId> MutualFriends::mutualFriendIds(const User& a, const User& b) {
+    std::vector<UserId> common;
+    IdSet::intersect(a.getFriendIds(), b.getFriendIds(), &common);
+
+    const IdSet& restrictedA = a.getRestrictedFriendIds();
+    const IdSet& restrictedB = b.getRestrictedFriendIds();
+    if (!restrictedA.empty() || !restrictedB.empty()) {
+        common.erase(std::remove_if(common.begin(), common.end(), [&](UserId id) {
+            return restrictedA.contains(id) || restrictedB.contains(id);
+        }), common.end());
+    }
+    return common;
+}
+
+std::vector<User*> MutualFriends::mutualFriends(const User& a, const User& b) const {
+    std::vector<User*> result;
+    for (UserId id : mutualFriendIds(a, b)) {
+        if (User* user = directory.findById(id)) {
+            result.push_back(user);
+        }
+    }
+    return result;
+}
+
+std::size_t MutualFriends::countMutualFriends(const User& a, const User& b) const {
+    return mutualFriendIds(a, b).size();
+}
+
+std::vector<FriendSuggestion> MutualFriends::suggestFriends(const User& user, std::size_t k,
+                                                            unsigned threads) const {
+    if (k == 0) return {};
+
+    std::vector<const User*> friends;
+    friends.reserve(user.getFriendIds().size());
+    std::size_t edges = 0;
+    for (UserId id : user.getFriendIds()) {
+        if (const User* friendUser = directory.findById(id)) {
+            friends.push_back(friendUser);
+            edges += friendUser->getFriendIds().size();
+        }
+    }
+
+    if (threads == 0) {
+        threads = edges < PARALLEL_EDGE_THRESHOLD ? 1 : std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, friends.size()));
+
+    // Each worker aggregates a slice of the friend list into its own map
+    std::vector<CountMap> partials(std::max(1u, threads));
+    if (threads <= 1) {
+        countFriendsOfFriends(friends, 0, friends.size(), partials[0]);
+    } else {
+        std::vector<std::thread> workers;
+        std::size_t chunk = (friends.size() + threads - 1) / threads;
+        for (unsigned t = 0; t < threads; ++t) {
+            std::size_t begin = t * chunk;
+            std::size_t end = std::min(friends.size(), begin + chunk);
+            workers.emplace_back(countFriendsOfFriends, std::cref(friends), begin, end,
+                                 std::ref(partials[t]));
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (unsigned t = 1; t < threads; ++t) {
+            for (const auto& [id, count] : partials[t]) {
+                partials[0][id] += count;
+            }
+        }
+    }
+
+    std::vector<std::pair<UserId, std::uint32_t>> ranked;
+    ranked.reserve(partials[0].size());
+    for (const auto& [id, count] : partials[0]) {
+        if (id == user.getId() || user.isFriend(id) || user.isBlocked(id)) continue;
+        ranked.emplace_back(id, count);
+    }
+
+    auto byRank = [](const auto& lhs, const auto& rhs) {
+        return lhs.second != rhs.second ? lhs.second > rhs.second : lhs.first < rhs.first;
+    };
+
+    std::vector<FriendSuggestion> suggestions;
+    std::size_t taken = 0;
+    // Candidates may be filtered below, so widen the partial sort until k survive
+    for (std::size_t window = std::min(k, ranked.size()); taken < ranked.size(); ) {
+        std::partial_sort(ranked.begin() + taken, ranked.begin() + window, ranked.end(), byRank);
+        for (; taken < window && suggestions.size() < k; ++taken) {
+            User* candidate = directory.findById(ranked[taken].first);
+            if (candidate && !candidate->isBlocked(user.getId())) {
+                suggestions.push_back({candidate, ranked[taken].second});
+            }
+        }
+        if (suggestions.size() >= k) break;
+        window = std::min(ranked.size(), window + k);
+    }
+    return suggestions;
+}
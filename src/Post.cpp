@@ -1,17 +1,34 @@
 #include "../include/Post.h"
 #include "../include/User.h"
+#include "../include/Timestamp.h"
+#include "../include/PostStore.h"
 
 Post::Post(User* user, const std::string& content, const std::string& timestamp, PostPrivacy privacy)
-    : user(user), content(content), timestamp(timestamp), privacy(privacy) {
+    : user(user), content(content), timestamp(timestamp),
+      epoch(Timestamp::toEpoch(timestamp)), privacy(privacy) {
     id = nextId++;
 }
 
+Post::Post(int id, User* user, const std::string& content, const std::string& timestamp, PostPrivacy privacy)
+    : id(id), user(user), content(content), timestamp(timestamp),
+      epoch(Timestamp::toEpoch(timestamp)), privacy(privacy) {
+    nextId = std::max(nextId, id + 1);
+}
+
 Post::~Post() {
     for (auto comment : comments) {
         delete comment;
     }
 }
 
+void Post::setPrivacy(PostPrivacy newPrivacy) {
+    privacy = newPrivacy;
+    touch();
+    if (store) {
+        store->reindexPrivacy(this);
+    }
+}
+
 void Post::tagUser(User* user) {
     if (std::find(taggedUsers.begin(), taggedUsers.end(), user) == taggedUsers.end()) {
         taggedUsers.push_back(user);
@@ -30,7 +47,7 @@ bool Post::canUserView(const User* viewer) const {
     }
     
     if (privacy == PostPrivacy::FRIENDS_ONLY) {
-        return user->isFriend(viewer->getUsername());
+        return user->isFriend(viewer->getId());
     }
     
     return false;
@@ -45,3 +62,19 @@ Comment* Post::addComment(User* author, const std::string& content) {
 std::string Post::getAuthorUsername() const {
     return user ? user->getUsername() : "";
 }
+
+std::vector<std::string> Post::getLikes() const {
+    return User::namesOf(likes);
+}
+
+void Post::addLike(const std::string& username) {
+    addLike(User::idOf(username));
+}
+
+void Post::removeLike(const std::string& username) {
+    removeLike(User::findId(username));
+}
+
+bool Post::hasLiked(const std::string& username) const {
+    return hasLiked(User::findId(username));
+}
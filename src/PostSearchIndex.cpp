@@ -0,0 +1,269 @@
+#include "../include/PostSearchIndex.h"
+#include "../include/Post.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <iterator>
+#include <unordered_set>
+
+namespace {
+
+bool isWordChar(unsigned char c) {
+    // Bytes >= 0x80 belong to UTF-8 sequences (emoji, non-Latin scripts) and stay inside words
+    return std::isalnum(c) || c == '_' || c >= 0x80;
+}
+
+std::vector<int> intersectSorted(const std::vector<int>& a, const std::vector<int>& b) {
+    std::vector<int> result;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+    return result;
+}
+
+}
+
+std::vector<PostSearchIndex::Token> PostSearchIndex::tokenize(const std::string& text) {
+    std::vector<Token> tokens;
+    std::uint32_t position = 0;
+    std::size_t i = 0;
+    const std::size_t n = text.size();
+
+    while (i < n) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        bool hashtag = c == '#' && i + 1 < n && isWordChar(static_cast<unsigned char>(text[i + 1]));
+        if (!hashtag && !isWordChar(c)) {
+            ++i;
+            continue;
+        }
+
+        std::string term;
+        if (hashtag) {
+            term.push_back('#');
+            ++i;
+        }
+        while (i < n && isWordChar(static_cast<unsigned char>(text[i]))) {
+            term.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(text[i]))));
+            ++i;
+        }
+        tokens.push_back({std::move(term), position++});
+    }
+    return tokens;
+}
+
+void PostSearchIndex::addPost(const Post* post) {
+    if (!post || documentLengths.count(post->getId())) return;
+
+    // Group positions per term, adding the bare word for every hashtag
+    std::unordered_map<std::string, std::vector<std::uint32_t>> termPositions;
+    auto tokens = tokenize(post->getContent());
+    for (const auto& token : tokens) {
+        termPositions[token.term].push_back(token.position);
+        if (token.term.size() > 1 && token.term[0] == '#') {
+            termPositions[token.term.substr(1)].push_back(token.position);
+        }
+    }
+
+    for (auto& [term, positions] : termPositions) {
+        auto& list = postings[term];
+        Posting posting{post->getId(), std::move(positions)};
+        if (list.empty() || list.back().postId < post->getId()) {
+            list.push_back(std::move(posting));
+        } else {
+            auto it = std::lower_bound(list.begin(), list.end(), post->getId(),
+                [](const Posting& p, int id) { return p.postId < id; });
+            list.insert(it, std::move(posting));
+        }
+    }
+    documentLengths[post->getId()] = static_cast<std::uint32_t>(tokens.size());
+}
+
+void PostSearchIndex::removePost(const Post* post) {
+    if (!post || !documentLengths.erase(post->getId())) return;
+
+    std::unordered_set<std::string> terms;
+    for (const auto& token : tokenize(post->getContent())) {
+        terms.insert(token.term);
+        if (token.term.size() > 1 && token.term[0] == '#') {
+            terms.insert(token.term.substr(1));
+        }
+    }
+
+    for (const auto& term : terms) {
+        auto entry = postings.find(term);
+        if (entry == postings.end()) continue;
+
+        auto& list = entry->second;
+        auto it = std::lower_bound(list.begin(), list.end(), post->getId(),
+            [](const Posting& p, int id) { return p.postId < id; });
+        if (it != list.end() && it->postId == post->getId()) {
+            list.erase(it);
+        }
+        if (list.empty()) {
+            postings.erase(entry);
+        }
+    }
+}
+
+void PostSearchIndex::clear() {
+    postings.clear();
+    documentLengths.clear();
+}
+
+std::vector<PostSearchIndex::Clause> PostSearchIndex::parseQuery(const std::string& query) {
+    std::vector<Clause> clauses(1);
+    std::size_t i = 0;
+    const std::size_t n = query.size();
+
+    while (i < n) {
+        if (std::isspace(static_cast<unsigned char>(query[i]))) {
+            ++i;
+            continue;
+        }
+
+        if (query[i] == '"') {
+            std::size_t close = query.find('"', i + 1);
+            if (close == std::string::npos) close = n;
+            std::vector<std::string> phrase;
+            for (auto& token : tokenize(query.substr(i + 1, close - i - 1))) {
+                phrase.push_back(std::move(token.term));
+            }
+            if (phrase.size() == 1) {
+                clauses.back().terms.push_back(std::move(phrase[0]));
+            } else if (!phrase.empty()) {
+                clauses.back().phrases.push_back(std::move(phrase));
+            }
+            i = close + 1;
+            continue;
+        }
+
+        std::size_t end = i;
+        while (end < n && !std::isspace(static_cast<unsigned char>(query[end])) && query[end] != '"') {
+            ++end;
+        }
+        std::string word = query.substr(i, end - i);
+        i = end;
+
+        if (word == "OR") {
+            if (!clauses.back().terms.empty() || !clauses.back().phrases.empty()) {
+                clauses.emplace_back();
+            }
+            continue;
+        }
+        for (auto& token : tokenize(word)) {
+            clauses.back().terms.push_back(std::move(token.term));
+        }
+    }
+
+    if (clauses.back().terms.empty() && clauses.back().phrases.empty()) {
+        clauses.pop_back();
+    }
+    return clauses;
+}
+
+const std::vector<PostSearchIndex::Posting>* PostSearchIndex::findPostings(const std::string& term) const {
+    auto it = postings.find(term);
+    return it != postings.end() ? &it->second : nullptr;
+}
+
+const PostSearchIndex::Posting* PostSearchIndex::findPosting(const std::vector<Posting>& list, int postId) {
+    auto it = std::lower_bound(list.begin(), list.end(), postId,
+        [](const Posting& p, int id) { return p.postId < id; });
+    return (it != list.end() && it->postId == postId) ? &*it : nullptr;
+}
+
+bool PostSearchIndex::matchesPhrase(int postId, const std::vector<std::string>& phrase) const {
+    std::vector<const std::vector<std::uint32_t>*> positions;
+    for (const auto& term : phrase) {
+        const auto* list = findPostings(term);
+        const Posting* posting = list ? findPosting(*list, postId) : nullptr;
+        if (!posting) return false;
+        positions.push_back(&posting->positions);
+    }
+
+    for (std::uint32_t start : *positions[0]) {
+        bool match = true;
+        for (std::size_t k = 1; k < positions.size() && match; ++k) {
+            match = std::binary_search(positions[k]->begin(), positions[k]->end(),
+                                       start + static_cast<std::uint32_t>(k));
+        }
+        if (match) return true;
+    }
+    return false;
+}
+
+double PostSearchIndex::idf(const std::vector<Posting>& list) const {
+    return std::log(1.0 + static_cast<double>(documentLengths.size()) / list.size());
+}
+
+std::vector<int> PostSearchIndex::search(const std::string& query, std::size_t limit) const {
+    std::unordered_map<int, double> scores;
+
+    for (const auto& clause : parseQuery(query)) {
+        // Every term of the clause, including the words of its phrases, must be present
+        std::vector<const std::vector<Posting>*> lists;
+        bool missing = false;
+        auto collect = [&](const std::string& term) {
+            const auto* list = findPostings(term);
+            if (list) lists.push_back(list);
+            else missing = true;
+        };
+        for (const auto& term : clause.terms) collect(term);
+        for (const auto& phrase : clause.phrases) {
+            for (const auto& term : phrase) collect(term);
+        }
+        if (missing || lists.empty()) continue;
+
+        // Intersect starting from the rarest term
+        std::sort(lists.begin(), lists.end(),
+            [](const auto* a, const auto* b) { return a->size() < b->size(); });
+        std::vector<int> candidates;
+        candidates.reserve(lists[0]->size());
+        for (const auto& posting : *lists[0]) {
+            candidates.push_back(posting.postId);
+        }
+        for (std::size_t k = 1; k < lists.size() && !candidates.empty(); ++k) {
+            std::vector<int> ids;
+            ids.reserve(lists[k]->size());
+            for (const auto& posting : *lists[k]) {
+                ids.push_back(posting.postId);
+            }
+            candidates = intersectSorted(candidates, ids);
+        }
+
+        for (int postId : candidates) {
+            bool phrasesMatch = true;
+            for (const auto& phrase : clause.phrases) {
+                if (!matchesPhrase(postId, phrase)) {
+                    phrasesMatch = false;
+                    break;
+                }
+            }
+            if (!phrasesMatch) continue;
+
+            double score = 0.0;
+            for (const auto* list : lists) {
+                const Posting* posting = findPosting(*list, postId);
+                score += posting->positions.size() * idf(*list);
+            }
+            double& best = scores[postId];
+            best = std::max(best, score);
+        }
+    }
+
+    std::vector<std::pair<int, double>> ranked(scores.begin(), scores.end());
+    auto byScore = [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first > b.first;
+    };
+    if (limit > 0 && limit < ranked.size()) {
+        std::partial_sort(ranked.begin(), ranked.begin() + limit, ranked.end(), byScore);
+        ranked.resize(limit);
+    } else {
+        std::sort(ranked.begin(), ranked.end(), byScore);
+    }
+
+    std::vector<int> result;
+    result.reserve(ranked.size());
+    for (const auto& entry : ranked) {
+        result.push_back(entry.first);
+    }
+    return result;
+}
@@ -0,0 +1,149 @@
+#include "../include/PostStore.h"
+#include "../include/Post.h"
+#include "../include/User.h"
+#include <algorithm>
+
+PostStore::~PostStore() {
+    clear();
+}
+
+Post* PostStore::addPost(std::unique_ptr<Post> post) {
+    if (!post || post->getId() < 0 || contains(post->getId())) return nullptr;
+
+    post->store = this;
+    posts.push_back(post.get());
+    std::size_t slot = static_cast<std::size_t>(post->getId());
+    std::size_t denseLimit = std::max(MIN_DENSE_SLOTS, posts.size() * DENSE_SLOTS_PER_POST);
+    if (slot >= slots.size()) {
+        if (slot >= denseLimit) {
+            sparse.emplace(post->getId(), std::move(post));
+            return posts.back();
+        }
+        std::size_t size = std::min(std::max(slot + 1, slots.size() * 2), denseLimit);
+        slots.resize(size);
+        authorIds.resize(size, INVALID_USER_ID);
+        epochs.resize(size, 0);
+        privacies.resize(size, 0);
+        // Sparse ids now inside the table move into it, so every id below
+        // slots.size() is looked up in the table alone
+        for (auto it = sparse.begin(); it != sparse.end();) {
+            if (static_cast<std::size_t>(it->first) < size) {
+                place(std::move(it->second));
+                it = sparse.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    place(std::move(post));
+    return posts.back();
+}
+
+void PostStore::place(std::unique_ptr<Post> post) {
+    std::size_t slot = static_cast<std::size_t>(post->getId());
+    authorIds[slot] = post->getUser() ? post->getUser()->getId() : INVALID_USER_ID;
+    epochs[slot] = post->getEpoch();
+    privacies[slot] = static_cast<std::uint8_t>(post->getPrivacy());
+    slots[slot] = std::move(post);
+}
+
+std::unique_ptr<Post> PostStore::removePost(Post* post) {
+    if (!post || findById(post->getId()) != post) return nullptr;
+
+    // Newest posts are the likeliest to be deleted, so search from the back
+    auto it = std::find(posts.rbegin(), posts.rend(), post);
+    if (it != posts.rend()) {
+        posts.erase(std::next(it).base());
+    }
+    post->store = nullptr;
+    if (!isDense(post->getId())) {
+        auto node = sparse.extract(post->getId());
+        return std::move(node.mapped());
+    }
+    authorIds[post->getId()] = INVALID_USER_ID;
+    return std::move(slots[post->getId()]);
+}
+
+Post* PostStore::findSparse(int postId) const {
+    auto it = sparse.find(postId);
+    return it != sparse.end() ? it->second.get() : nullptr;
+}
+
+void PostStore::clear() {
+    posts.clear();
+    slots.clear();
+    sparse.clear();
+    authorIds.clear();
+    epochs.clear();
+    privacies.clear();
+}
+
+void PostStore::reindexPrivacy(const Post* post) {
+    // Sparse posts have no columns; they are read from the Post itself
+    if (isDense(post->getId())) {
+        privacies[post->getId()] = static_cast<std::uint8_t>(post->getPrivacy());
+    }
+}
+
+UserId PostStore::authorOf(int postId) const {
+    if (isDense(postId)) return authorIds[postId];
+    Post* post = findById(postId);
+    return post && post->getUser() ? post->getUser()->getId() : INVALID_USER_ID;
+}
+
+std::int64_t PostStore::epochOf(int postId) const {
+    if (isDense(postId)) return contains(postId) ? epochs[postId] : 0;
+    Post* post = findById(postId);
+    return post ? post->getEpoch() : 0;
+}
+
+PostPrivacy PostStore::privacyOf(int postId) const {
+    if (isDense(postId)) return contains(postId) ? static_cast<PostPrivacy>(privacies[postId]) : PostPrivacy::PUBLIC;
+    Post* post = findById(postId);
+    return post ? post->getPrivacy() : PostPrivacy::PUBLIC;
+}
+
+std::vector<int> PostStore::idsBetween(std::int64_t fromEpoch, std::int64_t toEpoch, PostPrivacy widest) const {
+    // Branch-free filter over the columns: every slot is written and the
+    // output cursor advances only for matches, so the loop has no
+    // data-dependent jumps and the compilers can vectorize the tests
+    const std::uint8_t maxPrivacy = static_cast<std::uint8_t>(widest);
+    std::vector<int> ids(authorIds.size() + 1);
+    std::size_t count = 0;
+    for (std::size_t id = 0; id < authorIds.size(); ++id) {
+        bool match = (authorIds[id] != INVALID_USER_ID) & (epochs[id] >= fromEpoch) &
+                     (epochs[id] < toEpoch) & (privacies[id] <= maxPrivacy);
+        ids[count] = static_cast<int>(id);
+        count += match;
+    }
+    ids.resize(count);
+
+    if (!sparse.empty()) {
+        for (const auto& [id, post] : sparse) {
+            std::int64_t epoch = post->getEpoch();
+            if (post->getUser() && epoch >= fromEpoch && epoch < toEpoch &&
+                static_cast<std::uint8_t>(post->getPrivacy()) <= maxPrivacy) {
+                ids.push_back(id);
+            }
+        }
+        // Sparse ids are all past the table, so sorting them keeps id order
+        std::sort(ids.begin() + static_cast<std::ptrdiff_t>(count), ids.end());
+    }
+    return ids;
+}
+
+std::vector<Post*> PostStore::postsBetween(std::int64_t fromEpoch, std::int64_t toEpoch, PostPrivacy widest) const {
+    std::vector<int> ids = idsBetween(fromEpoch, toEpoch, widest);
+    // Ordered on the columns; only the matches are dereferenced
+    auto epochAt = [this](int id) { return isDense(id) ? epochs[id] : epochOf(id); };
+    std::sort(ids.begin(), ids.end(), [&](int a, int b) {
+        std::int64_t ea = epochAt(a), eb = epochAt(b);
+        return ea != eb ? ea > eb : a > b;
+    });
+    std::vector<Post*> result;
+    result.reserve(ids.size());
+    for (int id : ids) {
+        result.push_back(findById(id));
+    }
+    return result;
+}
@@ -0,0 +1,107 @@
+#include "../include/StartupLoader.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+double StartupReport::totalMilliseconds() const {
+    double total = 0;
+    for (const auto& phase : phases) total += phase.milliseconds;
+    return total;
+}
+
+void StartupReport::print() const {
+    std::cout << "\n[Timing]       Startup phases:" << std::endl;
+    for (const auto& phase : phases) {
+        std::cout << "[Timing]         " << std::setw(12) << std::left << phase.name
+                  << std::fixed << std::setprecision(2) << phase.milliseconds << " ms" << std::endl;
+    }
+    std::cout << "[Timing]         " << std::setw(12) << std::left << "total"
+              << std::fixed << std::setprecision(2) << totalMilliseconds() << " ms\n" << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+}
+
+StartupLoader::StartupLoader(unsigned threads, std::size_t chunkBytes)
+    : threads(threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threads),
+      chunkBytes(std::max<std::size_t>(chunkBytes, 1)) {}
+
+std::size_t StartupLoader::addFile(const std::string& path, std::size_t fields) {
+    File file;
+    file.path = path;
+    file.fields = std::min(std::max<std::size_t>(fields, 1), MAX_FIELDS);
+    files.push_back(std::move(file));
+    return files.size() - 1;
+}
+
+void StartupLoader::parseAll() {
+    struct Chunk {
+        std::size_t file;
+        const char* first;
+        const char* last;
+        std::vector<Row> rows;
+    };
+
+    // Map the files and cut each into ranges that end on a newline
+    std::vector<Chunk> chunks;
+    for (std::size_t f = 0; f < files.size(); ++f) {
+        File& file = files[f];
+        file.rows.clear();
+        file.source = std::make_unique<DelimitedReader>();
+        file.opened = file.source->open(file.path);
+        if (!file.opened || file.source->size() == 0) continue;
+
+        const char* first = file.source->data();
+        const char* last = first + file.source->size();
+        while (first < last) {
+            const char* cut = last;
+            if (static_cast<std::size_t>(last - first) > chunkBytes) {
+                const void* newline = std::memchr(first + chunkBytes, '\n', last - first - chunkBytes);
+                cut = newline ? static_cast<const char*>(newline) + 1 : last;
+            }
+            chunks.push_back({f, first, cut, {}});
+            first = cut;
+        }
+    }
+
+    std::atomic<std::size_t> nextChunk{0};
+    auto work = [&] {
+        DelimitedReader reader;
+        DelimitedReader::Record record;
+        for (std::size_t i = nextChunk++; i < chunks.size(); i = nextChunk++) {
+            Chunk& chunk = chunks[i];
+            const std::size_t fields = files[chunk.file].fields;
+            reader.attach(chunk.first, chunk.last);
+            while (reader.next(record, fields)) {
+                if (record.size() < fields) continue;
+                Row row{};
+                std::copy(record.fields.begin(), record.fields.begin() + fields, row.begin());
+                chunk.rows.push_back(row);
+            }
+        }
+    };
+
+    unsigned workers = static_cast<unsigned>(std::min<std::size_t>(threads, chunks.size()));
+    if (workers <= 1) {
+        work();
+    } else {
+        std::vector<std::thread> pool;
+        for (unsigned t = 0; t < workers; ++t) {
+            pool.emplace_back(work);
+        }
+        for (auto& thread : pool) {
+            thread.join();
+        }
+    }
+
+    // Chunks were created in file order, so appending them restores it
+    for (Chunk& chunk : chunks) {
+        auto& rows = files[chunk.file].rows;
+        if (rows.empty()) {
+            rows = std::move(chunk.rows);
+        } else {
+            rows.insert(rows.end(), chunk.rows.begin(), chunk.rows.end());
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#include "../include/StorageEngine.h"
+#include "../include/AtomicFile.h"
+#include "../include/User.h"
+#include <filesystem>
+#include <iostream>
+
+std::string StorageEngine::chatKey(const std::string& user1, const std::string& user2) {
+    return user1 < user2 ? user1 + "_" + user2 : user2 + "_" + user1;
+}
+
+std::string_view StorageEngine::chatPeer(const std::string& key, const std::string& sender) {
+    std::string_view view(key);
+    if (view.size() > sender.size() && view.compare(0, sender.size(), sender) == 0 &&
+        view[sender.size()] == '_') {
+        return view.substr(sender.size() + 1);
+    }
+    if (view.size() > sender.size()) {
+        return view.substr(0, view.size() - sender.size() - 1);
+    }
+    return {};
+}
+
+PostPrivacy StorageEngine::toPrivacy(std::uint32_t value) {
+    return value <= static_cast<std::uint32_t>(PostPrivacy::PRIVATE)
+        ? static_cast<PostPrivacy>(value) : PostPrivacy::PUBLIC;
+}
+
+std::uint32_t StorageEngine::userFlags(const User& user) {
+    std::uint32_t flags = 0;
+    if (user.isBot()) flags |= USER_BOT;
+    if (user.isPublic()) flags |= USER_PUBLIC;
+    return flags;
+}
+
+bool StorageEngine::commit(const FileImages& images) {
+    bool ok = true;
+    for (const auto& image : images) {
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path(image.path).parent_path(), ec);
+        if (!AtomicFile::write(image.path, image.bytes)) {
+            std::cout << "[Error]        Could not write " << image.path << std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool StorageEngine::save(const Dataset& data) {
+    FileImages images;
+    return encode(data, images) && commit(images);
+}
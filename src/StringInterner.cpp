@@ -0,0 +1,57 @@
+#include "../include/StringInterner.h"
+#include <stdexcept>
+
+StringInterner& StringInterner::usernames() {
+    static StringInterner instance;
+    return instance;
+}
+
+std::uint32_t StringInterner::intern(const std::string& value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = ids.find(value);
+    if (it != ids.end()) {
+        return it->second;
+    }
+
+    std::uint32_t id = static_cast<std::uint32_t>(strings.size());
+    strings.push_back(value);
+    ids.emplace(value, id);
+    return id;
+}
+
+std::uint32_t StringInterner::find(const std::string& value) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = ids.find(value);
+    return it != ids.end() ? it->second : npos;
+}
+
+const std::string& StringInterner::str(std::uint32_t id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (id >= strings.size()) {
+        throw std::out_of_range("StringInterner: unknown id");
+    }
+    return strings[id];
+}
+
+void StringInterner::rename(std::uint32_t id, const std::string& newValue) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (id >= strings.size()) {
+        throw std::out_of_range("StringInterner: unknown id");
+    }
+    auto taken = ids.find(newValue);
+    if (taken != ids.end() && taken->second != id) {
+        throw std::invalid_argument("StringInterner: value already interned under another id");
+    }
+
+    auto old = ids.find(strings[id]);
+    if (old != ids.end() && old->second == id) {
+        ids.erase(old);
+    }
+    strings[id] = newValue;
+    ids[newValue] = id;
+}
+
+std::size_t StringInterner::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return strings.size();
+}
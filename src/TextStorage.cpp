@@ -0,0 +1,360 @@
+#include "../include/TextStorage.h"
+#include "../include/StartupLoader.h"
+#include "../include/User.h"
+#include "../include/MappedFile.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unordered_set>
+
+namespace {
+
+const char* const FILE_NAMES[TextStorage::FILE_COUNT] = {
+    "users.txt", "posts.txt", "friends.txt", "likes.txt", "messages.txt"
+};
+const char* const PHASE_NAMES[TextStorage::FILE_COUNT] = {
+    "users", "posts", "friends", "likes", "messages"
+};
+// Fields per line, before and after the schema was unified
+const std::size_t LEGACY_FIELDS[TextStorage::FILE_COUNT] = {4, 4, 2, 2, 4};
+const std::size_t FIELDS[TextStorage::FILE_COUNT] = {5, 5, 2, 2, 4};
+
+using Rows = std::vector<StartupLoader::Row>;
+
+bool parseInt(std::string_view text, int& value) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+// Decodes the fields of a schema 2 row; legacy rows are used as they are
+struct Fields {
+    std::array<std::string, StartupLoader::MAX_FIELDS> scratch;
+    bool escaped;
+
+    std::string_view operator()(const StartupLoader::Row& row, std::size_t i) {
+        return escaped ? TextStorage::unescape(row[i], scratch[i]) : row[i];
+    }
+};
+
+void readUsers(const Rows& rows, int schema, StorageEngine::Sink& sink) {
+    Fields field{{}, schema >= 2};
+    for (const auto& row : rows) {
+        StorageEngine::UserRow user;
+        if (schema >= 2) {
+            user.username = field(row, 0);
+            user.email = field(row, 1);
+            user.password = field(row, 2);
+            user.gender = field(row, 3);
+            int flags = 0;
+            parseInt(row[4], flags);
+            user.flags = static_cast<std::uint32_t>(flags);
+        } else {
+            // Both column orders were written; the email is the one with an '@'
+            bool emailFirst = row[0].find('@') != std::string_view::npos &&
+                              row[1].find('@') == std::string_view::npos;
+            user.username = emailFirst ? row[1] : row[0];
+            user.email = emailFirst ? row[0] : row[1];
+            user.password = row[2];
+            user.gender = row[3];
+            user.flags = StorageEngine::USER_PUBLIC;  // profiles were public unless changed
+        }
+        sink.user(user);
+    }
+}
+
+void readPosts(const Rows& rows, int schema, StorageEngine::Sink& sink) {
+    Fields field{{}, schema >= 2};
+    for (const auto& row : rows) {
+        StorageEngine::PostRow post;
+        int value = 0;
+        if (schema >= 2) {
+            if (!parseInt(row[0], post.id)) post.id = -1;
+            post.author = field(row, 1);
+            if (parseInt(row[2], value)) post.privacy = StorageEngine::toPrivacy(value);
+            post.timestamp = field(row, 3);
+            post.content = field(row, 4);
+        } else if (parseInt(row[0], post.id)) {
+            // id|author|content|timestamp
+            post.author = row[1];
+            post.content = row[2];
+            post.timestamp = row[3];
+        } else {
+            // author|content|timestamp|privacy
+            post.id = -1;
+            post.author = row[0];
+            post.content = row[1];
+            post.timestamp = row[2];
+            if (parseInt(row[3], value)) post.privacy = StorageEngine::toPrivacy(value);
+        }
+        sink.post(post);
+    }
+}
+
+void readLikes(const Rows& rows, int schema, StorageEngine::Sink& sink) {
+    Fields field{{}, schema >= 2};
+    for (const auto& row : rows) {
+        StorageEngine::LikeRow like;
+        if (!parseInt(row[0], like.postId)) continue;
+        like.username = field(row, 1);
+        sink.like(like);
+    }
+}
+
+void readFriendships(const Rows& rows, int schema, StorageEngine::Sink& sink) {
+    Fields field{{}, schema >= 2};
+    for (const auto& row : rows) {
+        sink.friendship({field(row, 0), field(row, 1)});
+    }
+}
+
+void readMessages(const Rows& rows, int schema, StorageEngine::Sink& sink) {
+    Fields field{{}, schema >= 2};
+    for (const auto& row : rows) {
+        if (schema >= 2) {
+            sink.message({field(row, 0), field(row, 1), field(row, 2), field(row, 3)});
+        } else {
+            sink.message({row[0], row[1], row[3], row[2]});
+        }
+    }
+}
+
+// Builds one file's contents
+class LineWriter {
+private:
+    std::string buffer;
+    bool first = true;
+
+public:
+    LineWriter() { buffer = "#schema " + std::to_string(TextStorage::SCHEMA_VERSION) + "\n"; }
+
+    LineWriter& field(std::string_view value) {
+        if (!first) buffer += '|';
+        TextStorage::escape(value, buffer);
+        first = false;
+        return *this;
+    }
+    LineWriter& field(long long value) {
+        if (!first) buffer += '|';
+        buffer += std::to_string(value);
+        first = false;
+        return *this;
+    }
+    void endLine() {
+        buffer += '\n';
+        first = true;
+    }
+
+    std::string take() { return std::move(buffer); }
+};
+
+}
+
+TextStorage::TextStorage(const std::string& directory) {
+    for (std::size_t f = 0; f < FILE_COUNT; ++f) {
+        paths[f] = (std::filesystem::path(directory) / FILE_NAMES[f]).generic_string();
+    }
+}
+
+TextStorage::FileSizes TextStorage::fileSizes() const {
+    FileSizes sizes{};
+    for (std::size_t f = 0; f < FILE_COUNT; ++f) {
+        std::error_code ec;
+        auto size = std::filesystem::file_size(paths[f], ec);
+        sizes[f] = ec ? 0 : static_cast<std::uint64_t>(size);
+    }
+    return sizes;
+}
+
+TextStorage::FileSizes TextStorage::expectedSizes() const {
+    FileSizes sizes = fileSizes();
+    for (std::size_t f = 0; f < FILE_COUNT; ++f) {
+        if (encoded[f]) sizes[f] = encodedSizes[f];
+    }
+    return sizes;
+}
+
+TextStorage::FileHashes TextStorage::fileHashes() const {
+    FileHashes hashes{};
+    for (std::size_t f = 0; f < FILE_COUNT; ++f) {
+        MappedFile file;
+        hashes[f] = file.open(paths[f]) ? hashOf({file.data(), file.size()}) : hashOf({});
+    }
+    return hashes;
+}
+
+TextStorage::FileHashes TextStorage::expectedHashes() const {
+    FileHashes hashes{};
+    bool stale = false;
+    for (std::size_t f = 0; f < FILE_COUNT; ++f) stale |= !encoded[f];
+    if (stale) hashes = fileHashes();
+    for (std::size_t f = 0; f < FILE_COUNT; ++f) {
+        if (encoded[f]) hashes[f] = encodedHashes[f];
+    }
+    return hashes;
+}
+
+std::uint64_t TextStorage::hashOf(std::string_view bytes) {
+    // FNV-1a: not cryptographic, only meant to notice edits and mismatches
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char c : bytes) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+int TextStorage::schemaOf(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::string line;
+    int version = 1;
+    if (std::getline(file, line) && line.compare(0, 8, "#schema ") == 0) {
+        parseInt(std::string_view(line).substr(8, line.find_first_of("\r", 8) - 8), version);
+    }
+    return version;
+}
+
+void TextStorage::escape(std::string_view field, std::string& out) {
+    for (char c : field) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '|': out += "\\p"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            default: out += c;
+        }
+    }
+}
+
+std::string_view TextStorage::unescape(std::string_view field, std::string& scratch) {
+    if (!std::memchr(field.data(), '\\', field.size())) return field;
+    scratch.clear();
+    for (std::size_t i = 0; i < field.size(); ++i) {
+        char c = field[i];
+        if (c == '\\' && i + 1 < field.size()) {
+            switch (field[++i]) {
+                case 'p': c = '|'; break;
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                default: c = field[i];
+            }
+        }
+        scratch += c;
+    }
+    return scratch;
+}
+
+bool TextStorage::load(Sink& sink, unsigned entities, StartupReport* report) {
+    auto timed = [report](const char* phase, auto&& fn) {
+        if (report) {
+            report->time(phase, fn);
+        } else {
+            fn();
+        }
+    };
+
+    StartupLoader loader;
+    std::array<std::size_t, FILE_COUNT> index{};
+    std::array<int, FILE_COUNT> schema{};
+    for (std::size_t f = 0; f < FILE_COUNT; ++f) {
+        if (!(entities & (1u << f))) continue;
+        schema[f] = schemaOf(paths[f]);
+        index[f] = loader.addFile(paths[f], schema[f] >= 2 ? FIELDS[f] : LEGACY_FIELDS[f]);
+    }
+
+    // Every file is read and split concurrently; records are handed to the
+    // sink serially, in dependency order
+    timed("parse", [&] { loader.parseAll(); });
+
+    bool loaded = false;
+    using Reader = void (*)(const Rows&, int, Sink&);
+    const std::pair<File, Reader> order[] = {
+        {USERS_FILE, readUsers}, {POSTS_FILE, readPosts}, {LIKES_FILE, readLikes},
+        {FRIENDS_FILE, readFriendships}, {MESSAGES_FILE, readMessages}
+    };
+    for (const auto& [f, read] : order) {
+        if (!(entities & (1u << f))) continue;
+        if (!loader.opened(index[f])) {
+            std::cout << "[Warning]      Could not open " << paths[f] << std::endl;
+            continue;
+        }
+        const Rows& rows = loader.rows(index[f]);
+        std::cout << "[Success]      Read " << rows.size() << " records from " << paths[f] << std::endl;
+        timed(PHASE_NAMES[f], [&] { read(rows, schema[f], sink); });
+        loaded = true;
+    }
+    return loaded;
+}
+
+bool TextStorage::encode(const Dataset& data, FileImages& images) {
+    auto write = [&](File f, LineWriter& lines, std::size_t count) {
+        std::cout << "[Saving]       " << count << " " << PHASE_NAMES[f] << " to " << paths[f] << std::endl;
+        images.push_back({paths[f], lines.take()});
+        encodedSizes[f] = images.back().bytes.size();
+        encodedHashes[f] = hashOf(images.back().bytes);
+        encoded[f] = true;
+    };
+
+    if ((data.entities & USERS) && data.users) {
+        LineWriter lines;
+        for (const User* user : *data.users) {
+            lines.field(user->getUsername()).field(user->getEmail()).field(user->getPassword())
+                 .field(user->getGender()).field(userFlags(*user)).endLine();
+        }
+        write(USERS_FILE, lines, data.users->size());
+    }
+
+    if ((data.entities & FRIENDSHIPS) && data.users) {
+        LineWriter lines;
+        std::size_t count = 0;
+        // Each unordered pair once, whichever side holds the edge: a
+        // half-applied removal or a one-way legacy row must not be lost
+        std::unordered_set<std::uint64_t> written;
+        for (const User* user : *data.users) {
+            for (UserId friendId : user->getFriendIds()) {
+                UserId low = std::min(user->getId(), friendId);
+                UserId high = std::max(user->getId(), friendId);
+                if (!written.insert((static_cast<std::uint64_t>(low) << 32) | high).second) continue;
+                const std::string& friendName = User::nameOf(friendId);
+                bool userFirst = user->getUsername() < friendName;
+                lines.field(userFirst ? user->getUsername() : friendName)
+                     .field(userFirst ? friendName : user->getUsername()).endLine();
+                ++count;
+            }
+        }
+        write(FRIENDS_FILE, lines, count);
+    }
+
+    if ((data.entities & POSTS) && data.posts) {
+        LineWriter lines;
+        for (const Post* post : *data.posts) {
+            lines.field(post->getId()).field(post->getAuthorUsername())
+                 .field(static_cast<int>(post->getPrivacy()))
+                 .field(post->getTimestamp()).field(post->getContent()).endLine();
+        }
+        write(POSTS_FILE, lines, data.posts->size());
+    }
+
+    if ((data.entities & LIKES) && data.posts) {
+        LineWriter lines;
+        std::size_t count = 0;
+        for (const Post* post : *data.posts) {
+            for (UserId liker : post->getLikeIds()) {
+                lines.field(post->getId()).field(User::nameOf(liker)).endLine();
+                ++count;
+            }
+        }
+        write(LIKES_FILE, lines, count);
+    }
+
+    if ((data.entities & MESSAGES) && data.messages) {
+        LineWriter lines;
+        for (const auto& message : *data.messages) {
+            lines.field(message.from).field(message.to).field(message.timestamp)
+                 .field(message.text).endLine();
+        }
+        write(MESSAGES_FILE, lines, data.messages->size());
+    }
+    return true;
+}
@@ -0,0 +1,140 @@
+#include "../include/TimelineCache.h"
+#include "../include/PostStore.h"
+#include "../include/Post.h"
+#include "../include/User.h"
+#include <algorithm>
+
+void TimelineCache::Timeline::push(const Entry& entry) {
+    if (count < slots.size()) {
+        slots[(head + count) % slots.size()] = entry;
+        ++count;
+    } else {
+        // Full: overwrite the oldest entry
+        slots[head] = entry;
+        head = (head + 1) % slots.size();
+        complete = false;
+    }
+}
+
+TimelineCache::TimelineCache(const UserDirectory& directory, const PostStore& posts,
+                             std::size_t capacity, std::size_t fanoutThreshold)
+    : directory(directory), posts(posts), feed(directory),
+      capacity(std::max<std::size_t>(capacity, 1)), fanoutThreshold(fanoutThreshold) {}
+
+bool TimelineCache::isHot(const User& author) const {
+    if (hotAuthors.count(author.getId())) return true;
+    if (author.isBot() || author.getFriendIds().size() > fanoutThreshold) {
+        hotAuthors.insert(author.getId());
+        return true;
+    }
+    return false;
+}
+
+void TimelineCache::clear() {
+    timelines.clear();
+    hotAuthors.clear();
+}
+
+void TimelineCache::onPostCreated(const Post& post) {
+    const User* author = post.getUser();
+    if (!author || isHot(*author)) return;
+
+    const Entry entry{post.getEpoch(), post.getId()};
+    auto deliver = [&](UserId follower) {
+        auto it = timelines.find(follower);
+        if (it == timelines.end()) return;  // built on demand at first read
+
+        Timeline& timeline = it->second;
+        if (timeline.count > 0) {
+            const Entry& newest = timeline.newest(0);
+            bool inOrder = newest.epoch != entry.epoch ? newest.epoch < entry.epoch
+                                                       : newest.postId < entry.postId;
+            if (!inOrder) {
+                // Back-dated post: cheaper to rebuild than to shift the ring
+                timelines.erase(it);
+                return;
+            }
+        }
+        timeline.push(entry);
+    };
+
+    deliver(author->getId());
+    for (UserId friendId : author->getFriendIds()) {
+        deliver(friendId);
+    }
+}
+
+TimelineCache::Timeline& TimelineCache::timelineFor(const User& viewer) {
+    auto it = timelines.find(viewer.getId());
+    if (it != timelines.end()) return it->second;
+
+    std::vector<const User*> cold;
+    for (const User* author : feed.collectAuthors(viewer)) {
+        if (!isHot(*author)) cold.push_back(author);
+    }
+    FeedPage seed = feed.mergeAuthors(viewer, cold, FeedCursor(), capacity);
+
+    Timeline& timeline = timelines[viewer.getId()];
+    timeline.slots.resize(capacity);
+    for (auto post = seed.posts.rbegin(); post != seed.posts.rend(); ++post) {
+        timeline.push({(*post)->getEpoch(), (*post)->getId()});
+    }
+    timeline.complete = !seed.hasMore;
+    return timeline;
+}
+
+FeedPage TimelineCache::getFeed(const User& viewer, const FeedCursor& cursor, std::size_t pageSize) {
+    FeedPage page;
+    page.next = cursor;
+    if (pageSize == 0) return page;
+
+    const Timeline& timeline = timelineFor(viewer);
+
+    // Cold authors: straight from the ring, newest first
+    std::vector<Post*> cold;
+    std::size_t i = 0;
+    for (; i < timeline.count && cold.size() < pageSize; ++i) {
+        const Entry& entry = timeline.newest(i);
+        if (!cursor.precedes(entry.epoch, entry.postId)) continue;
+
+        // Cheap rejections come from the store's columns, before the post is touched
+        UserId authorId = posts.authorOf(entry.postId);
+        if (authorId == INVALID_USER_ID) continue;  // deleted since it was fanned out
+        if (authorId != viewer.getId()) {
+            if (!viewer.isFriend(authorId)) continue;
+            if (posts.privacyOf(entry.postId) == PostPrivacy::PRIVATE) continue;
+        }
+        Post* post = posts.findById(entry.postId);
+        const User* author = post->getUser();
+        if (isHot(*author)) continue;  // served by the read path below
+        if (!FeedService::isVisible(*post, viewer)) continue;
+        cold.push_back(post);
+    }
+    bool coldHasMore = i < timeline.count;
+    if (cold.size() < pageSize && !coldHasMore && !timeline.complete) {
+        // Paged past what the ring remembers
+        return feed.getFeed(viewer, cursor, pageSize);
+    }
+
+    // Hot authors: merged at read time
+    std::vector<const User*> hot;
+    for (const User* author : feed.collectAuthors(viewer)) {
+        if (isHot(*author)) hot.push_back(author);
+    }
+    FeedPage hotPage = feed.mergeAuthors(viewer, hot, cursor, pageSize);
+
+    std::size_t c = 0, h = 0;
+    page.posts.reserve(pageSize);
+    while (page.posts.size() < pageSize && (c < cold.size() || h < hotPage.posts.size())) {
+        bool takeCold = h == hotPage.posts.size() ||
+                        (c < cold.size() && Post::olderThan(hotPage.posts[h], cold[c]));
+        page.posts.push_back(takeCold ? cold[c++] : hotPage.posts[h++]);
+    }
+    if (!page.posts.empty()) {
+        page.next.epoch = page.posts.back()->getEpoch();
+        page.next.postId = page.posts.back()->getId();
+    }
+    page.hasMore = c < cold.size() || h < hotPage.posts.size() || hotPage.hasMore ||
+                   coldHasMore || !timeline.complete;
+    return page;
+}
@@ -0,0 +1,96 @@
+#include "../include/Timestamp.h"
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const char* const MONTHS[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                              "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+std::int64_t compose(std::int64_t year, unsigned month, unsigned day,
+                     unsigned hour, unsigned minute, unsigned second) {
+    if (month < 1 || month > 12 || day < 1 || day > 31) return 0;
+    return Timestamp::daysFromCivil(year, month, day) * 86400 +
+           hour * 3600 + minute * 60 + second;
+}
+
+}
+
+namespace Timestamp {
+
+// Howard Hinnant's days_from_civil: proleptic Gregorian date -> days since 1970-01-01
+std::int64_t daysFromCivil(std::int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    const std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(year - era * 400);
+    const unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+std::string format(std::int64_t epoch) {
+    std::int64_t days = epoch / 86400;
+    std::int64_t seconds = epoch % 86400;
+    if (seconds < 0) {
+        seconds += 86400;
+        --days;
+    }
+
+    // civil_from_days, the inverse of daysFromCivil
+    days += 719468;
+    const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(days - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned day = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned month = mp < 10 ? mp + 3 : mp - 9;
+    const std::int64_t year = static_cast<std::int64_t>(yoe) + era * 400 + (month <= 2);
+
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%04lld-%02u-%02u %02u:%02u:%02u",
+                  static_cast<long long>(year), month, day,
+                  static_cast<unsigned>(seconds / 3600), static_cast<unsigned>(seconds / 60 % 60),
+                  static_cast<unsigned>(seconds % 60));
+    return buffer;
+}
+
+std::int64_t toEpoch(const std::string& timestamp) {
+    if (timestamp.empty()) return 0;
+
+    // Plain epoch seconds
+    bool digitsOnly = true;
+    for (char c : timestamp) {
+        if (!std::isdigit(static_cast<unsigned char>(c))) {
+            digitsOnly = false;
+            break;
+        }
+    }
+    if (digitsOnly) {
+        return timestamp.size() <= 18 ? std::stoll(timestamp) : 0;
+    }
+
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+
+    // ISO-like "YYYY-MM-DD[ HH:MM[:SS]]"
+    int fields = std::sscanf(timestamp.c_str(), "%d-%d-%d %d:%d:%d",
+                             &year, &month, &day, &hour, &minute, &second);
+    if (fields >= 3) {
+        return compose(year, month, day, hour, minute, second);
+    }
+
+    // ctime "Www Mmm dd hh:mm:ss yyyy"
+    char weekday[4] = {0}, monthName[4] = {0};
+    if (std::sscanf(timestamp.c_str(), "%3s %3s %d %d:%d:%d %d",
+                    weekday, monthName, &day, &hour, &minute, &second, &year) == 7) {
+        for (unsigned m = 0; m < 12; ++m) {
+            if (std::strcmp(monthName, MONTHS[m]) == 0) {
+                return compose(year, m + 1, day, hour, minute, second);
+            }
+        }
+    }
+    return 0;
+}
+
+}
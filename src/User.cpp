@@ -1,48 +1,93 @@
 #include "../include/User.h"
+#include "../include/UserDirectory.h"
+#include "../include/StringInterner.h"
+#include "../include/MutualFriends.h"
 #include <sstream>
+#include <stdexcept>
 
 User::User(const std::string& username, const std::string& email,
            const std::string& password, const std::string& gender)
-    : username(username), email(email), password(password),
-      gender(gender), isUserBot(false), isPublicProfile(true) {
+    : id(idOf(username)), username(username), email(email), password(password),
+      gender(gender), isUserBot(false), isPublicProfile(true), directory(nullptr) {
 }
 
-void User::addFriend(const std::string& friendUsername) {
-    if (std::find(friends.begin(), friends.end(), friendUsername) == friends.end()) {
-        friends.push_back(friendUsername);
+User::~User() {
+    if (directory) {
+        directory->removeUser(this);
     }
 }
 
-void User::removeFriend(const std::string& friendUsername) {
-    auto it = std::find(friends.begin(), friends.end(), friendUsername);
-    if (it != friends.end()) {
-        friends.erase(it);
+void User::setUsername(const std::string& username) {
+    // The name may be interned for another id (e.g. as someone's friend)
+    // without a user having it; taking it over would repoint that id's edges.
+    // The interner is renamed first, and undone if the directory refuses, so
+    // the two never disagree about the name.
+    StringInterner& names = StringInterner::usernames();
+    try {
+        names.rename(id, username);
+    } catch (const std::invalid_argument&) {
+        throw UserAlreadyExistsException();
     }
+    if (directory && !directory->reindexUsername(this, this->username, username)) {
+        names.rename(id, this->username);
+        throw UserAlreadyExistsException();
+    }
+    this->username = username;
+    touch();
 }
 
-bool User::isFriend(const std::string& username) const {
-    return std::find(friends.begin(), friends.end(), username) != friends.end();
+void User::setEmail(const std::string& email) {
+    if (directory && !directory->reindexEmail(this, this->email, email)) {
+        throw UserAlreadyExistsException();
+    }
+    this->email = email;
+    touch();
 }
 
-bool User::hasFriend(const std::string& username) const {
-    return std::find(friends.begin(), friends.end(), username) != friends.end();
+UserId User::idOf(const std::string& username) {
+    return StringInterner::usernames().intern(username);
 }
 
-void User::addFriendRequest(const std::string& fromUsername) {
-    if (!hasFriendRequest(fromUsername)) {
-        friendRequests.push_back(fromUsername);
-    }
+UserId User::findId(const std::string& username) {
+    std::uint32_t id = StringInterner::usernames().find(username);
+    return id == StringInterner::npos ? INVALID_USER_ID : id;
 }
 
-void User::removeFriendRequest(const std::string& fromUsername) {
-    auto it = std::find(friendRequests.begin(), friendRequests.end(), fromUsername);
-    if (it != friendRequests.end()) {
-        friendRequests.erase(it);
+const std::string& User::nameOf(UserId id) {
+    return StringInterner::usernames().str(id);
+}
+
+std::vector<std::string> User::namesOf(const IdSet& ids) {
+    std::vector<std::string> names;
+    names.reserve(ids.size());
+    for (UserId id : ids) {
+        names.push_back(nameOf(id));
     }
+    return names;
+}
+
+void User::addFriend(UserId friendId) {
+    if (friends.insert(friendId)) touch();
+}
+
+void User::removeFriend(UserId friendId) {
+    if (friends.erase(friendId)) touch();
+}
+
+bool User::hasFriend(UserId friendId) const {
+    return friends.contains(friendId);
+}
+
+void User::addFriendRequest(UserId fromId) {
+    friendRequests.insert(fromId);
 }
 
-bool User::hasFriendRequest(const std::string& fromUsername) const {
-    return std::find(friendRequests.begin(), friendRequests.end(), fromUsername) != friendRequests.end();
+void User::removeFriendRequest(UserId fromId) {
+    friendRequests.erase(fromId);
+}
+
+bool User::hasFriendRequest(UserId fromId) const {
+    return friendRequests.contains(fromId);
 }
 
 bool User::checkPassword(const std::string& password) const {
@@ -52,48 +97,52 @@ bool User::checkPassword(const std::string& password) const {
 bool User::changePassword(const std::string& oldPassword, const std::string& newPassword) {
     if (checkPassword(oldPassword)) {
         this->password = newPassword;
+        touch();
         return true;
     }
     return false;
 }
 
-void User::restrictFriend(const std::string& friendUsername) {
-    if (isFriend(friendUsername) && 
-        std::find(restrictedFriends.begin(), restrictedFriends.end(), friendUsername) == restrictedFriends.end()) {
-        restrictedFriends.push_back(friendUsername);
+void User::restrictFriend(UserId friendId) {
+    if (isFriend(friendId)) {
+        restrictedFriends.insert(friendId);
     }
 }
 
-void User::unrestrictFriend(const std::string& friendUsername) {
-    auto it = std::find(restrictedFriends.begin(), restrictedFriends.end(), friendUsername);
-    if (it != restrictedFriends.end()) {
-        restrictedFriends.erase(it);
-    }
+void User::unrestrictFriend(UserId friendId) {
+    restrictedFriends.erase(friendId);
 }
 
-bool User::isRestrictedFriend(const std::string& username) const {
-    return std::find(restrictedFriends.begin(), restrictedFriends.end(), username) != restrictedFriends.end();
+bool User::isRestrictedFriend(UserId friendId) const {
+    return restrictedFriends.contains(friendId);
 }
 
-void User::blockUser(const std::string& username) {
+void User::blockUser(UserId userId) {
     // Remove from friends if they are a friend
-    removeFriend(username);
+    removeFriend(userId);
     
     // Add to blocked users if not already blocked
-    if (std::find(blockedUsers.begin(), blockedUsers.end(), username) == blockedUsers.end()) {
-        blockedUsers.push_back(username);
-    }
+    blockedUsers.insert(userId);
 }
 
-void User::unblockUser(const std::string& username) {
-    auto it = std::find(blockedUsers.begin(), blockedUsers.end(), username);
-    if (it != blockedUsers.end()) {
-        blockedUsers.erase(it);
-    }
+void User::unblockUser(UserId userId) {
+    blockedUsers.erase(userId);
+}
+
+bool User::isBlocked(UserId userId) const {
+    return blockedUsers.contains(userId);
 }
 
-bool User::isBlocked(const std::string& username) const {
-    return std::find(blockedUsers.begin(), blockedUsers.end(), username) != blockedUsers.end();
+void User::addPost(Post* post) {
+    if (!post) return;
+
+    // New posts are almost always the newest, so this is an append; loaded or
+    // back-dated posts are placed by binary search
+    if (posts.empty() || Post::olderThan(posts.back(), post)) {
+        posts.push_back(post);
+    } else {
+        posts.insert(std::upper_bound(posts.begin(), posts.end(), post, Post::olderThan), post);
+    }
 }
 
 std::string User::serialize() const {
@@ -107,14 +156,14 @@ std::string User::serialize() const {
     
     // Serialize friends
     ss << "|";
-    for (const auto& friend_ : friends) {
-        ss << friend_ << ",";
+    for (UserId friendId : friends) {
+        ss << nameOf(friendId) << ",";
     }
     
     // Serialize friend requests
     ss << "|";
-    for (const auto& request : friendRequests) {
-        ss << request << ",";
+    for (UserId requestId : friendRequests) {
+        ss << nameOf(requestId) << ",";
     }
     
     return ss.str();
@@ -164,8 +213,8 @@ std::vector<Post*> User::operator+(const User& other) const {
     std::vector<Post*> commonPosts;
     
     // If users are not friends or one has restricted/blocked the other, return empty vector
-    if (!isFriend(other.getUsername()) || isRestrictedFriend(other.getUsername()) || 
-        isBlocked(other.getUsername()) || other.isBlocked(getUsername())) {
+    if (!isFriend(other.id) || isRestrictedFriend(other.id) || 
+        isBlocked(other.id) || other.isBlocked(id)) {
         return commonPosts;
     }
     
@@ -190,19 +239,21 @@ std::vector<Post*> User::operator+(const User& other) const {
 std::vector<User*> User::operator&(const User& other) const {
     std::vector<User*> mutualFriends;
     
+    // Friends are stored as ids, which only a directory can turn back into users
+    if (!directory) {
+        return mutualFriends;
+    }
+    
     // If users are not friends or one has restricted/blocked the other, return empty vector
-    if (!isFriend(other.getUsername()) || isRestrictedFriend(other.getUsername()) || 
-        isBlocked(other.getUsername()) || other.isBlocked(getUsername())) {
+    if (!isFriend(other.id) || isRestrictedFriend(other.id) || 
+        isBlocked(other.id) || other.isBlocked(id)) {
         return mutualFriends;
     }
     
-    // Find common friends
-    for (const auto& friendUsername : friends) {
-        if (other.isFriend(friendUsername)) {
-            // Note: This requires access to the FacebookSystem to get User* from username
-            // For now, we'll return an empty vector
-            // In a real implementation, we'd need to pass the FacebookSystem instance
-            // or have some way to look up User* from username
+    // Find common friends, resolving ids through our directory
+    for (UserId friendId : MutualFriends::mutualFriendIds(*this, other)) {
+        if (User* mutual = directory->findById(friendId)) {
+            mutualFriends.push_back(mutual);
         }
     }
     
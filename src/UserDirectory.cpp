@@ -0,0 +1,88 @@
+#include "../include/UserDirectory.h"
+#include "../include/User.h"
+#include <algorithm>
+
+UserDirectory::~UserDirectory() {
+    clear();
+}
+
+bool UserDirectory::addUser(User* user) {
+    if (!user || user->directory) return false;
+    if (hasUsername(user->getUsername()) || hasEmail(user->getEmail())) {
+        return false;
+    }
+
+    users.push_back(user);
+    usernameIndex.emplace(user->getUsername(), user);
+    emailIndex.emplace(user->getEmail(), user);
+    idIndex[user->getId()] = user;
+    searchIndex.addUser(user);
+    user->directory = this;
+    return true;
+}
+
+bool UserDirectory::removeUser(User* user) {
+    if (!user || user->directory != this) return false;
+
+    auto it = std::find(users.begin(), users.end(), user);
+    if (it != users.end()) {
+        users.erase(it);
+    }
+    usernameIndex.erase(user->getUsername());
+    emailIndex.erase(user->getEmail());
+    searchIndex.removeUser(user, user->getUsername(), user->getEmail());
+    auto byId = idIndex.find(user->getId());
+    if (byId != idIndex.end() && byId->second == user) {
+        idIndex.erase(byId);
+    }
+    user->directory = nullptr;
+    return true;
+}
+
+void UserDirectory::clear() {
+    for (auto* user : users) {
+        user->directory = nullptr;
+    }
+    users.clear();
+    usernameIndex.clear();
+    emailIndex.clear();
+    idIndex.clear();
+    searchIndex.clear();
+}
+
+User* UserDirectory::findByUsername(const std::string& username) const {
+    auto it = usernameIndex.find(username);
+    return it != usernameIndex.end() ? it->second : nullptr;
+}
+
+User* UserDirectory::findByEmail(const std::string& email) const {
+    auto it = emailIndex.find(email);
+    return it != emailIndex.end() ? it->second : nullptr;
+}
+
+User* UserDirectory::findById(UserId id) const {
+    auto it = idIndex.find(id);
+    return it != idIndex.end() ? it->second : nullptr;
+}
+
+bool UserDirectory::reindexUsername(User* user, const std::string& oldUsername, const std::string& newUsername) {
+    if (oldUsername == newUsername) return true;
+    if (hasUsername(newUsername)) return false;
+
+    usernameIndex.erase(oldUsername);
+    usernameIndex.emplace(newUsername, user);
+    searchIndex.removeUser(user, oldUsername, user->getEmail());
+    searchIndex.addUser(user, newUsername, user->getEmail());
+    return true;
+}
+
+bool UserDirectory::reindexEmail(User* user, const std::string& oldEmail, const std::string& newEmail) {
+    if (oldEmail == newEmail) return true;
+    if (hasEmail(newEmail)) return false;
+
+    emailIndex.erase(oldEmail);
+    emailIndex.emplace(newEmail, user);
+    searchIndex.removeUser(user, user->getUsername(), oldEmail);
+    searchIndex.addUser(user, user->getUsername(), newEmail);
+    return true;
+}
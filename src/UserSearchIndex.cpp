@@ -0,0 +1,161 @@
+#include "../include/UserSearchIndex.h"
+#include "../include/User.h"
+#include "../include/UserDirectory.h"
+#include <algorithm>
+#include <cctype>
+#include <unordered_set>
+
+std::string UserSearchIndex::fold(const std::string& value) {
+    std::string folded = value;
+    std::transform(folded.begin(), folded.end(), folded.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return folded;
+}
+
+void UserSearchIndex::collectTrigrams(const std::string& key, std::vector<std::uint32_t>& out) {
+    for (std::size_t i = 0; i + 3 <= key.size(); ++i) {
+        out.push_back((static_cast<std::uint32_t>(static_cast<unsigned char>(key[i])) << 16) |
+                      (static_cast<std::uint32_t>(static_cast<unsigned char>(key[i + 1])) << 8) |
+                      static_cast<std::uint32_t>(static_cast<unsigned char>(key[i + 2])));
+    }
+}
+
+void UserSearchIndex::addTrigrams(const std::string& username, const std::string& email, UserId id) {
+    std::vector<std::uint32_t> grams;
+    collectTrigrams(username, grams);
+    collectTrigrams(email, grams);
+    for (std::uint32_t gram : grams) {
+        trigrams[gram].insert(id);
+    }
+}
+
+void UserSearchIndex::removeTrigrams(const std::string& username, const std::string& email, UserId id) {
+    std::vector<std::uint32_t> grams;
+    collectTrigrams(username, grams);
+    collectTrigrams(email, grams);
+    for (std::uint32_t gram : grams) {
+        auto it = trigrams.find(gram);
+        if (it == trigrams.end()) continue;
+        it->second.erase(id);
+        if (it->second.empty()) {
+            trigrams.erase(it);
+        }
+    }
+}
+
+void UserSearchIndex::addUser(User* user) {
+    addUser(user, user->getUsername(), user->getEmail());
+}
+
+void UserSearchIndex::addUser(User* user, const std::string& rawUsername, const std::string& rawEmail) {
+    std::string username = fold(rawUsername);
+    std::string email = fold(rawEmail);
+    if (infixEnabled) {
+        addTrigrams(username, email, user->getId());
+    }
+    usernameKeys.emplace(std::move(username), user);
+    emailKeys.emplace(std::move(email), user);
+}
+
+void UserSearchIndex::removeUser(User* user, const std::string& username, const std::string& email) {
+    std::string foldedUsername = fold(username);
+    std::string foldedEmail = fold(email);
+    if (infixEnabled) {
+        removeTrigrams(foldedUsername, foldedEmail, user->getId());
+    }
+    usernameKeys.erase({foldedUsername, user});
+    emailKeys.erase({foldedEmail, user});
+}
+
+void UserSearchIndex::clear() {
+    usernameKeys.clear();
+    emailKeys.clear();
+    trigrams.clear();
+}
+
+void UserSearchIndex::setInfixEnabled(bool enabled) {
+    if (enabled == infixEnabled) return;
+    infixEnabled = enabled;
+    trigrams.clear();
+    if (enabled) {
+        for (const auto& [username, user] : usernameKeys) {
+            addTrigrams(username, fold(user->getEmail()), user->getId());
+        }
+    }
+}
+
+std::vector<User*> UserSearchIndex::search(const std::string& query, std::size_t limit,
+                                           const UserDirectory& directory) const {
+    std::vector<User*> results;
+    std::unordered_set<User*> seen;
+    auto full = [&]() { return limit > 0 && results.size() >= limit; };
+    auto take = [&](User* user) {
+        if (seen.insert(user).second) {
+            results.push_back(user);
+        }
+    };
+
+    const std::string needle = fold(query);
+
+    // Prefix matches: a range scan starting at the first key >= needle
+    for (const KeySet* keys : {&usernameKeys, &emailKeys}) {
+        for (auto it = keys->lower_bound({needle, nullptr});
+             it != keys->end() && !full() && it->first.compare(0, needle.size(), needle) == 0; ++it) {
+            take(it->second);
+        }
+    }
+
+    if (full() || !infixEnabled || needle.size() < 3) {
+        return results;
+    }
+
+    // Infix matches: intersect the posting sets of every trigram in the query
+    std::vector<std::uint32_t> grams;
+    collectTrigrams(needle, grams);
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+
+    std::vector<const IdSet*> sets;
+    for (std::uint32_t gram : grams) {
+        auto it = trigrams.find(gram);
+        if (it == trigrams.end()) return results;
+        sets.push_back(&it->second);
+    }
+    std::sort(sets.begin(), sets.end(),
+              [](const IdSet* a, const IdSet* b) { return a->size() < b->size(); });
+
+    // Walk the smallest set and probe the others with a galloping search from
+    // where the previous probe stopped, so a short result never costs a full
+    // pass over a common trigram's postings
+    std::vector<std::size_t> cursors(sets.size(), 0);
+    auto inAll = [&](UserId id) {
+        for (std::size_t k = 1; k < sets.size(); ++k) {
+            const std::vector<UserId>& values = sets[k]->values();
+            std::size_t low = cursors[k];
+            std::size_t step = 1;
+            while (low + step < values.size() && values[low + step] < id) {
+                low += step;
+                step *= 2;
+            }
+            auto first = values.begin() + low;
+            auto last = values.begin() + std::min(low + step + 1, values.size());
+            auto it = std::lower_bound(first, last, id);
+            cursors[k] = static_cast<std::size_t>(it - values.begin());
+            if (it == values.end() || *it != id) return false;
+        }
+        return true;
+    };
+
+    // Trigrams can co-occur without forming the substring, so verify each candidate
+    for (UserId id : *sets[0]) {
+        if (full()) break;
+        if (!inAll(id)) continue;
+        User* user = directory.findById(id);
+        if (!user || seen.count(user)) continue;
+        if (fold(user->getUsername()).find(needle) != std::string::npos ||
+            fold(user->getEmail()).find(needle) != std::string::npos) {
+            take(user);
+        }
+    }
+    return results;
+}
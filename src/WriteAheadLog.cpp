@@ -0,0 +1,191 @@
+#include "../include/WriteAheadLog.h"
+#include <fstream>
+#include <filesystem>
+#include <iterator>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include "../include/AtomicFile.h"
+
+WriteAheadLog::WriteAheadLog(const std::string& path, std::size_t syncEvery,
+                             std::chrono::milliseconds syncInterval)
+    : path(path), syncEvery(syncEvery == 0 ? 1 : syncEvery), syncInterval(syncInterval),
+      lastSync(std::chrono::steady_clock::now()) {}
+
+WriteAheadLog::~WriteAheadLog() {
+    close();
+}
+
+bool WriteAheadLog::open() {
+    if (file) return true;
+    trimTornTail();
+    file = std::fopen(path.c_str(), "ab");
+    if (!file) {
+        std::cout << std::setw(15) << std::left << "[Error]" << "Could not open " << path << std::endl;
+        return false;
+    }
+    lastSync = std::chrono::steady_clock::now();
+    return true;
+}
+
+void WriteAheadLog::trimTornTail() {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec || size == 0) return;
+
+    std::ifstream in(path, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    if (contents.back() == '\n') return;
+
+    // Drop the partial record so the next append starts on a fresh line
+    std::size_t lastNewline = contents.find_last_of('\n');
+    std::filesystem::resize_file(path, lastNewline == std::string::npos ? 0 : lastNewline + 1, ec);
+}
+
+void WriteAheadLog::close() {
+    if (!file) return;
+    sync();
+    std::fclose(file);
+    file = nullptr;
+}
+
+void WriteAheadLog::append(const Record& record) {
+    if (!file) return;
+    std::string line = encode(record);
+    line += '\n';
+    std::fwrite(line.data(), 1, line.size(), file);
+    ++records;
+    ++unsynced;
+
+    if (unsynced >= syncEvery || std::chrono::steady_clock::now() - lastSync >= syncInterval) {
+        sync();
+    }
+}
+
+void WriteAheadLog::sync() {
+    if (!file) return;
+    if (unsynced > 0) {
+        AtomicFile::sync(file);
+        unsynced = 0;
+    }
+    lastSync = std::chrono::steady_clock::now();
+}
+
+std::size_t WriteAheadLog::replay(const std::function<void(const Record&)>& apply) {
+    if (file) std::fflush(file);
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return 0;
+
+    std::size_t replayed = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (in.eof()) break;  // no trailing newline: torn write
+        if (line.empty()) continue;
+        apply(decode(line));
+        ++replayed;
+    }
+    if (!file) records = replayed;
+    return replayed;
+}
+
+void WriteAheadLog::truncate() {
+    bool wasOpen = file != nullptr;
+    if (wasOpen) {
+        std::fclose(file);
+        file = nullptr;
+    }
+    std::FILE* empty = std::fopen(path.c_str(), "wb");
+    if (empty) {
+        AtomicFile::sync(empty);
+        std::fclose(empty);
+    }
+    records = 0;
+    unsynced = 0;
+    if (wasOpen) open();
+}
+
+bool WriteAheadLog::retire(std::uint64_t generation) {
+    bool wasOpen = file != nullptr;
+    close();
+    std::error_code ec;
+    if (std::filesystem::exists(path, ec)) {
+        std::filesystem::rename(path, retiredPath(generation), ec);
+    }
+    if (ec) {
+        std::cout << std::setw(15) << std::left << "[Error]" << "Could not retire " << path
+                  << ": " << ec.message() << std::endl;
+        if (wasOpen) open();
+        return false;
+    }
+    records = 0;
+    unsynced = 0;
+    if (wasOpen) open();
+    return true;
+}
+
+std::string WriteAheadLog::retiredPath(std::uint64_t generation) const {
+    return path + "." + std::to_string(generation);
+}
+
+std::vector<std::pair<std::uint64_t, std::string>> WriteAheadLog::retiredLogs(const std::string& path) {
+    std::vector<std::pair<std::uint64_t, std::string>> logs;
+    std::filesystem::path live(path);
+    std::string prefix = live.filename().string() + ".";
+    std::error_code ec;
+    std::filesystem::path dir = live.has_parent_path() ? live.parent_path() : std::filesystem::path(".");
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0) continue;
+        std::string suffix = name.substr(prefix.size());
+        if (suffix.find_first_not_of("0123456789") != std::string::npos) continue;
+        logs.emplace_back(std::stoull(suffix), entry.path().string());
+    }
+    std::sort(logs.begin(), logs.end());
+    return logs;
+}
+
+void WriteAheadLog::removeRetired(const std::string& path, std::uint64_t upToGeneration) {
+    // What the checkpoint renamed into place must be on disk before the logs
+    // it covers are deleted
+    AtomicFile::syncDirectory(path);
+    for (const auto& [generation, retired] : retiredLogs(path)) {
+        if (generation > upToGeneration) break;
+        std::error_code ec;
+        std::filesystem::remove(retired, ec);
+    }
+}
+
+std::string WriteAheadLog::encode(const Record& record) {
+    std::string line;
+    for (std::size_t i = 0; i < record.size(); ++i) {
+        if (i > 0) line += '|';
+        for (char c : record[i]) {
+            switch (c) {
+                case '|':  line += "\\|"; break;
+                case '\\': line += "\\\\"; break;
+                case '\n': line += "\\n"; break;
+                case '\r': line += "\\r"; break;
+                default:   line += c;
+            }
+        }
+    }
+    return line;
+}
+
+WriteAheadLog::Record WriteAheadLog::decode(const std::string& line) {
+    Record record(1);
+    for (std::size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+        if (c == '|') {
+            record.emplace_back();
+        } else if (c == '\\' && i + 1 < line.size()) {
+            char next = line[++i];
+            record.back() += next == 'n' ? '\n' : next == 'r' ? '\r' : next;
+        } else {
+            record.back() += c;
+        }
+    }
+    return record;
+}
@@ -1,7 +1,10 @@
 #include <gtest/gtest.h>
 #include "../include/FacebookSystem.h"
+#include "../include/Timestamp.h"
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <set>
 
 class FacebookSystemTest : public ::testing::Test {
 protected:
@@ -16,6 +19,10 @@ protected:
                 std::filesystem::remove(dataDir / "friends.txt");
                 std::filesystem::remove(dataDir / "posts.txt");
                 std::filesystem::remove(dataDir / "messages.txt");
+                std::filesystem::remove(dataDir / "likes.txt");
+                std::filesystem::remove(dataDir / "wal.log");
+                std::filesystem::remove(dataDir / "snapshot.bin");
+                std::filesystem::remove_all(dataDir / "messages");
                 std::cout << "Removed existing data files" << std::endl;
             }
 
@@ -48,6 +55,35 @@ TEST_F(FacebookSystemTest, UserRegistration) {
     EXPECT_FALSE(system->registerUser("newuser", "ahmed@test.com", "pass123", "male"));
 }
 
+TEST_F(FacebookSystemTest, DefaultBotsAreFlaggedAndStayFlagged) {
+    for (const char* name : {"Bot_Alice", "Bot_Bob"}) {
+        ASSERT_NE(system->findUserByUsername(name), nullptr);
+        EXPECT_TRUE(system->findUserByUsername(name)->isBot());
+    }
+    // Logging out checkpoints; the flag is saved with the users
+    ASSERT_TRUE(system->login("ahmed@test.com", "pass123"));
+    system->logout();
+    system->flush();
+    delete system;
+
+    std::filesystem::path dataDir = std::filesystem::current_path().parent_path() / "data";
+    std::ifstream usersFile(dataDir / "users.txt");
+    std::string line;
+    int flagged = 0;
+    while (std::getline(usersFile, line)) {
+        if (line.rfind("Bot_", 0) != 0) continue;
+        std::string flags = line.substr(line.rfind('|') + 1);
+        flagged += (std::stoi(flags) & StorageEngine::USER_BOT) != 0;
+    }
+    EXPECT_EQ(flagged, 2);
+
+    system = new FacebookSystem();
+    for (const char* name : {"Bot_Alice", "Bot_Bob"}) {
+        ASSERT_NE(system->findUserByUsername(name), nullptr);
+        EXPECT_TRUE(system->findUserByUsername(name)->isBot());
+    }
+}
+
 TEST_F(FacebookSystemTest, UserLogin) {
     // Test successful login
     EXPECT_TRUE(system->login("ahmed@test.com", "pass123"));
@@ -112,7 +148,8 @@ TEST_F(FacebookSystemTest, CreateAndInteractWithPost) {
     
     // Create post
     system->createPost("Test post content");
-    auto posts = system->getPosts();
+    // The default bots have posts of their own
+    auto posts = system->getCurrentUser()->getPosts();
     EXPECT_EQ(posts.size(), 1);
     EXPECT_EQ(posts[0]->getContent(), "Test post content");
     
@@ -127,6 +164,18 @@ TEST_F(FacebookSystemTest, CreateAndInteractWithPost) {
     EXPECT_EQ(posts[0]->getComments()[0]->getContent(), "Test comment");
 }
 
+TEST_F(FacebookSystemTest, SearchByAuthorReturnsEachPostOnce) {
+    system->login("sara@test.com", "pass789");
+    for (int i = 0; i < 50; ++i) {
+        system->createPost(i % 2 ? "note " + std::to_string(i) : "sara says " + std::to_string(i));
+    }
+    // Half match the text as well as the author; none is listed twice
+    std::vector<Post*> found = system->searchPosts("sara");
+    EXPECT_EQ(found.size(), 50);
+    std::set<Post*> unique(found.begin(), found.end());
+    EXPECT_EQ(unique.size(), found.size());
+}
+
 TEST_F(FacebookSystemTest, PostVisibility) {
     system->login("ahmed@test.com", "pass123");
     system->createPost("Public post");
@@ -147,3 +196,145 @@ TEST_F(FacebookSystemTest, PostVisibility) {
     }
     EXPECT_TRUE(foundPost);
 }
+
+TEST_F(FacebookSystemTest, MessagesAreArchivedAndReadBackPerConversation) {
+    ASSERT_TRUE(system->login("ahmed@test.com", "pass123"));
+    system->sendMessage("sara", "hi sara");
+    system->sendMessage("mohamed", "hi mohamed");
+    system->sendMessage("sara", "are you there?");
+    EXPECT_EQ(system->getMessages("sara").size(), 2);
+    EXPECT_EQ(system->getInbox().size(), 2);
+    EXPECT_EQ(system->getUnreadMessageCount(), 0);  // nothing received
+    system->logout();
+    system->flush();
+    delete system;
+
+    // Sending appended to the archive; the data files hold no messages
+    system = new FacebookSystem();
+    std::filesystem::path dataDir = std::filesystem::current_path().parent_path() / "data";
+    std::ifstream messagesFile(dataDir / "messages.txt");
+    std::string line, rows;
+    while (std::getline(messagesFile, line)) {
+        if (!line.empty() && line[0] != '#') rows += line;
+    }
+    EXPECT_EQ(rows, "");
+
+    ASSERT_TRUE(system->login("sara@test.com", "pass789"));
+    auto inbox = system->getInbox();
+    ASSERT_EQ(inbox.size(), 1);
+    EXPECT_EQ(inbox[0].peer, "ahmed");
+    EXPECT_EQ(inbox[0].preview, "are you there?");
+    EXPECT_EQ(inbox[0].unread, 2);
+    EXPECT_EQ(system->getUnreadMessageCount(), 2);
+    MessageRange chat = system->getMessages("ahmed");
+    ASSERT_EQ(chat.size(), 2);
+    EXPECT_EQ(chat[0].text, "hi sara");
+    EXPECT_EQ(chat[1].text, "are you there?");
+    EXPECT_EQ(User::nameOf(chat[1].from), "ahmed");
+    EXPECT_GT(chat[1].epoch, 0);
+    EXPECT_TRUE(system->getMessages("mohamed").empty());
+
+    // Read markers are saved with the archive index
+    system->markConversationRead("ahmed");
+    EXPECT_EQ(system->getUnreadMessageCount(), 0);
+    system->logout();
+    system->flush();
+    delete system;
+    system = new FacebookSystem();
+    ASSERT_TRUE(system->login("sara@test.com", "pass789"));
+    EXPECT_EQ(system->getInbox()[0].unread, 0);
+}
+
+TEST_F(FacebookSystemTest, LegacyMessagesKeepTheirSendTimes) {
+    system->flush();
+    delete system;
+
+    // A pre-archive messages.txt in the oldest column order (text before time)
+    std::filesystem::path dataDir = std::filesystem::current_path().parent_path() / "data";
+    std::filesystem::remove(dataDir / "snapshot.bin");
+    std::filesystem::remove_all(dataDir / "messages");
+    std::ofstream(dataDir / "messages.txt", std::ios::trunc)
+        << "ahmed|sara|hi|2024-01-01 12:05:00\nsara|ahmed|hello|2024-01-02 08:00:00\n";
+
+    // Importing them, and every save after that, keeps the original times
+    for (int run = 0; run < 2; ++run) {
+        system = new FacebookSystem();
+        ASSERT_TRUE(system->login("sara@test.com", "pass789"));
+        MessageRange chat = system->getMessages("ahmed");
+        ASSERT_EQ(chat.size(), 2);
+        EXPECT_EQ(chat[0].epoch, Timestamp::toEpoch("2024-01-01 12:05:00"));
+        EXPECT_EQ(chat[1].epoch, Timestamp::toEpoch("2024-01-02 08:00:00"));
+        system->logout();
+        system->flush();
+        delete system;
+    }
+    system = new FacebookSystem();
+}
+
+TEST_F(FacebookSystemTest, SnapshotMessagesKeepTheirSendTimes) {
+    system->flush();
+    delete system;
+
+    // A pre-archive snapshot that still carries the messages
+    std::filesystem::path dataDir = std::filesystem::current_path().parent_path() / "data";
+    std::filesystem::remove(dataDir / "wal.log");
+    std::filesystem::remove_all(dataDir / "messages");
+    {
+        User ahmed("ahmed", "ahmed@test.com", "pass123", "male");
+        User sara("sara", "sara@test.com", "pass789", "female");
+        std::vector<User*> userList = {&ahmed, &sara};
+        std::vector<Post*> postList;
+        std::vector<StorageEngine::MessageRow> messages = {
+            {"ahmed", "sara", "2024-01-01 12:05:00", "hi"},
+            {"sara", "ahmed", "2024-01-02 08:00:00", "hello"}
+        };
+        StorageEngine::Dataset data;
+        data.users = &userList;
+        data.posts = &postList;
+        data.messages = &messages;
+        TextStorage text(dataDir.string());
+        BinaryStorage binary((dataDir / "snapshot.bin").string(), &text);
+        ASSERT_TRUE(text.save(data));
+        ASSERT_TRUE(binary.save(data));
+    }
+
+    for (int run = 0; run < 2; ++run) {
+        system = new FacebookSystem();
+        ASSERT_TRUE(system->login("sara@test.com", "pass789"));
+        MessageRange chat = system->getMessages("ahmed");
+        ASSERT_EQ(chat.size(), 2);
+        EXPECT_EQ(chat[0].epoch, Timestamp::toEpoch("2024-01-01 12:05:00"));
+        EXPECT_EQ(chat[1].epoch, Timestamp::toEpoch("2024-01-02 08:00:00"));
+        system->logout();
+        system->flush();
+        delete system;
+    }
+    system = new FacebookSystem();
+}
+
+TEST_F(FacebookSystemTest, ReplayingARetiredLogTwiceDoesNotDuplicateMessages) {
+    system->flush();
+    delete system;
+
+    // A log retired before messages had their own archive
+    std::filesystem::path dataDir = std::filesystem::current_path().parent_path() / "data";
+    std::string retired = WriteAheadLog::encode({"MESSAGE", "ahmed", "sara", "2024-01-01 12:05:00", "hi"}) + "\n" +
+                          WriteAheadLog::encode({"MESSAGE", "ahmed", "sara", "2024-01-01 12:06:00", "again"}) + "\n";
+    std::ofstream(dataDir / "wal.log.1", std::ios::binary | std::ios::trunc) << retired;
+
+    // The second run is a crash after the checkpoint committed but before the
+    // retired log was removed: its messages are already in the archive
+    for (int run = 0; run < 2; ++run) {
+        system = new FacebookSystem();
+        ASSERT_TRUE(system->login("sara@test.com", "pass789"));
+        MessageRange chat = system->getMessages("ahmed");
+        ASSERT_EQ(chat.size(), 2);
+        EXPECT_EQ(chat[1].text, "again");
+        system->logout();
+        system->flush();
+        delete system;
+        std::ofstream(dataDir / "wal.log.1", std::ios::binary | std::ios::trunc) << retired;
+    }
+    std::filesystem::remove(dataDir / "wal.log.1");
+    system = new FacebookSystem();
+}
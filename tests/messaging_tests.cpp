@@ -2,6 +2,8 @@
 #include "../include/User.h"
 #include "../include/Message.h"
 #include "../include/Conversation.h"
+#include "../include/ConversationStore.h"
+#include "../include/Timestamp.h"
 
 class MessagingTest : public ::testing::Test {
 protected:
@@ -95,3 +97,121 @@ TEST_F(MessagingTest, MessageAccess) {
     EXPECT_FALSE(conversation->hasParticipant(user3));
     delete user3;
 }
+
+TEST_F(MessagingTest, ConversationStoreKeysByIdPair) {
+    ConversationStore store;
+    store.append(user1->getId(), user2->getId(), 100, "Hi");
+    store.append(user2->getId(), user1->getId(), 160, "Hello back");
+    EXPECT_EQ(store.size(), 1);
+    EXPECT_EQ(store.messageCount(), 2);
+
+    // Either order finds the same conversation
+    MessageRange chat = store.messagesBetween(user2->getId(), user1->getId());
+    ASSERT_EQ(chat.size(), 2);
+    EXPECT_EQ(chat[0].from, user1->getId());
+    EXPECT_EQ(chat[1].text, "Hello back");
+    EXPECT_EQ(store.find(user1->getId(), user2->getId()), store.find(user2->getId(), user1->getId()));
+    EXPECT_TRUE(store.messagesBetween(user1->getId(), user1->getId() + 1000).empty());
+
+    ConversationKey key = store.begin()->first;
+    EXPECT_TRUE(key.involves(user1->getId()));
+    EXPECT_EQ(key.peerOf(user1->getId()), user2->getId());
+}
+
+TEST_F(MessagingTest, MessageLogAppendsWithoutMovingMessages) {
+    ConversationStore store;
+    store.append(user1->getId(), user2->getId(), 0, "first");
+    const MessageLog* log = store.find(user1->getId(), user2->getId());
+    const char* first = (*log)[0].text.data();
+    MessageRange before = store.messagesBetween(user1->getId(), user2->getId());
+    std::uint64_t version = log->getVersion();
+
+    // Several chunks' worth of appends, and new conversations, leave earlier
+    // messages where they were
+    for (std::size_t i = 1; i < 3 * MessageLog::CHUNK_SIZE + 5; ++i) {
+        store.append(user2->getId(), user1->getId(), static_cast<std::int64_t>(i), std::to_string(i));
+        store.append(user2->getId(), user2->getId() + 1 + static_cast<UserId>(i), 0, "other");
+    }
+    EXPECT_EQ((*log)[0].text.data(), first);
+    EXPECT_EQ(before.size(), 1);
+    EXPECT_GT(log->getVersion(), version);
+
+    MessageRange all = store.messagesBetween(user1->getId(), user2->getId());
+    ASSERT_EQ(all.size(), 3 * MessageLog::CHUNK_SIZE + 5);
+    std::size_t seen = 0;
+    for (const ChatMessage& message : all) {
+        EXPECT_EQ(message.text, seen == 0 ? "first" : std::to_string(seen));
+        ++seen;
+    }
+    EXPECT_EQ(seen, all.size());
+}
+
+TEST_F(MessagingTest, MessageHistoryPagesBackwardsFromNewest) {
+    ConversationStore store;
+    for (int i = 0; i < 120; ++i) {
+        store.append(user1->getId(), user2->getId(), i, std::to_string(i));
+    }
+
+    MessagePage newest = store.page(user2->getId(), user1->getId(), MessageCursor(), 50);
+    ASSERT_EQ(newest.messages.size(), 50);
+    EXPECT_EQ(newest.messages[0].text, "70");
+    EXPECT_EQ(newest.messages.back().text, "119");
+    EXPECT_TRUE(newest.hasMore);
+
+    MessagePage middle = store.page(user1->getId(), user2->getId(), newest.next, 50);
+    ASSERT_EQ(middle.messages.size(), 50);
+    EXPECT_EQ(middle.messages[0].text, "20");
+    EXPECT_TRUE(middle.hasMore);
+
+    MessagePage oldest = store.page(user1->getId(), user2->getId(), middle.next, 50);
+    ASSERT_EQ(oldest.messages.size(), 20);
+    EXPECT_EQ(oldest.messages[0].text, "0");
+    EXPECT_FALSE(oldest.hasMore);
+
+    // New messages are picked up after the last position shown
+    store.append(user2->getId(), user1->getId(), 120, "reply");
+    MessageRange added = store.messagesBetween(user1->getId(), user2->getId()).after(newest.messages.endPosition());
+    ASSERT_EQ(added.size(), 1);
+    EXPECT_EQ(added[0].text, "reply");
+
+    EXPECT_TRUE(store.page(user1->getId(), user2->getId(), MessageCursor(), 0).messages.empty());
+    EXPECT_TRUE(store.page(user1->getId(), user1->getId() + 100, MessageCursor(), 10).messages.empty());
+}
+
+TEST_F(MessagingTest, MessageRecordsKeepSendTimeAndPackText) {
+    ConversationStore store;
+    std::string longText(3 * MessageLog::MAX_BLOCK, 'x');
+    store.append(user1->getId(), user2->getId(), Timestamp::toEpoch("2024-01-01 10:00:00"), "morning");
+    store.append(user2->getId(), user1->getId(), Timestamp::toEpoch("2024-01-01 12:30:00"), longText);
+    store.append(user1->getId(), user2->getId(), Timestamp::toEpoch("2024-01-02 09:15:00"), "next day");
+
+    MessageRange chat = store.messagesBetween(user1->getId(), user2->getId());
+    ASSERT_EQ(chat.size(), 3);
+    EXPECT_EQ(Timestamp::format(chat[0].epoch), "2024-01-01 10:00:00");
+    EXPECT_EQ(chat[1].text.size(), longText.size());
+    EXPECT_EQ(chat[2].text, "next day");
+    EXPECT_EQ(chat[2].from, user1->getId());
+
+    // Time ranges are cut by binary search over the records
+    MessageRange firstDay = store.messagesBetween(user2->getId(), user1->getId(),
+                                                  Timestamp::toEpoch("2024-01-01"), Timestamp::toEpoch("2024-01-02"));
+    ASSERT_EQ(firstDay.size(), 2);
+    EXPECT_EQ(firstDay[0].text, "morning");
+    EXPECT_TRUE(store.messagesBetween(user1->getId(), user2->getId(), 0, Timestamp::toEpoch("2023-12-31")).empty());
+
+    // A record is a fraction of a std::string-based message, and short
+    // texts share arena blocks rather than each getting an allocation
+    EXPECT_LE(sizeof(MessageLog::Record), 24u);
+    ConversationStore small;
+    for (int i = 0; i < 100; ++i) {
+        small.append(user1->getId(), user2->getId(), i, "hello there, how are you today?");
+    }
+    const MessageLog* log = small.find(user1->getId(), user2->getId());
+    EXPECT_LT(log->memoryUsage(), MessageLog::CHUNK_SIZE * sizeof(MessageLog::Record) + 100 * 64);
+}
+
+TEST(TimestampTest, FormatRoundTripsThroughToEpoch) {
+    EXPECT_EQ(Timestamp::format(0), "1970-01-01 00:00:00");
+    EXPECT_EQ(Timestamp::format(Timestamp::toEpoch("2024-02-29 23:59:59")), "2024-02-29 23:59:59");
+    EXPECT_EQ(Timestamp::toEpoch(Timestamp::format(1735448416)), 1735448416);
+}
@@ -0,0 +1,769 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include "../include/WriteAheadLog.h"
+#include "../include/BinarySnapshot.h"
+#include "../include/DelimitedReader.h"
+#include "../include/StartupLoader.h"
+#include "../include/TextStorage.h"
+#include "../include/BinaryStorage.h"
+#include "../include/AtomicFile.h"
+#include "../include/BackgroundWriter.h"
+#include "../include/MessageArchive.h"
+#include "../include/User.h"
+#include "../include/Post.h"
+
+class WriteAheadLogTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = (std::filesystem::temp_directory_path() / "wal_test.log").string();
+        std::filesystem::remove(path);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path);
+        WriteAheadLog::removeRetired(path, UINT64_MAX);
+    }
+
+    std::vector<WriteAheadLog::Record> readBack() {
+        WriteAheadLog reader(path);
+        std::vector<WriteAheadLog::Record> records;
+        reader.replay([&](const WriteAheadLog::Record& r) { records.push_back(r); });
+        return records;
+    }
+
+    std::string path;
+};
+
+TEST_F(WriteAheadLogTest, EncodingRoundTrips) {
+    WriteAheadLog::Record record{"POST", "7", "ahmed", "a|b\\c\nnext line", ""};
+    EXPECT_EQ(WriteAheadLog::decode(WriteAheadLog::encode(record)), record);
+}
+
+TEST_F(WriteAheadLogTest, AppendsAreReplayedInOrder) {
+    {
+        WriteAheadLog wal(path, 2);
+        ASSERT_TRUE(wal.open());
+        wal.append({"REGISTER", "ahmed", "ahmed@test.com", "pass", "male"});
+        EXPECT_EQ(wal.pending(), 1);
+        wal.append({"FRIEND_ADD", "ahmed", "sara"});
+        EXPECT_EQ(wal.pending(), 0);  // group of two was synced
+        wal.append({"LIKE", "3", "sara"});
+        EXPECT_EQ(wal.size(), 3);
+    }  // close() syncs the tail
+
+    auto records = readBack();
+    ASSERT_EQ(records.size(), 3);
+    EXPECT_EQ(records[0][1], "ahmed");
+    EXPECT_EQ(records[1][0], "FRIEND_ADD");
+    EXPECT_EQ(records[2], (WriteAheadLog::Record{"LIKE", "3", "sara"}));
+}
+
+TEST_F(WriteAheadLogTest, TornTailIsIgnoredAndTruncateEmpties) {
+    {
+        WriteAheadLog wal(path);
+        wal.open();
+        wal.append({"PASSWORD", "ahmed", "new"});
+    }
+    // Simulate a crash midway through the next record
+    std::ofstream(path, std::ios::app | std::ios::binary) << "FRIEND_ADD|ahm";
+    EXPECT_EQ(readBack().size(), 1);
+
+    // Reopening drops the fragment instead of appending onto it
+    WriteAheadLog wal(path);
+    wal.open();
+    wal.append({"LIKE", "2", "sara"});
+    wal.sync();
+    auto records = readBack();
+    ASSERT_EQ(records.size(), 2);
+    EXPECT_EQ(records[1], (WriteAheadLog::Record{"LIKE", "2", "sara"}));
+
+    wal.truncate();
+    EXPECT_EQ(wal.size(), 0);
+    EXPECT_TRUE(readBack().empty());
+    wal.append({"LIKE", "1", "sara"});
+    wal.sync();
+    EXPECT_EQ(readBack().size(), 1);
+}
+
+TEST_F(WriteAheadLogTest, RetiredLogsSurviveUntilRemoved) {
+    WriteAheadLog wal(path);
+    ASSERT_TRUE(wal.open());
+    wal.append({"LIKE", "1", "sara"});
+    wal.retire(2);
+    EXPECT_EQ(wal.size(), 0);
+    EXPECT_TRUE(wal.isOpen());
+    wal.append({"LIKE", "2", "sara"});
+    wal.retire(10);
+    wal.append({"LIKE", "3", "sara"});
+    wal.sync();
+
+    // Generations sort numerically, and the live log only has the newest record
+    auto retired = WriteAheadLog::retiredLogs(path);
+    ASSERT_EQ(retired.size(), 2);
+    EXPECT_EQ(retired[0].first, 2);
+    EXPECT_EQ(retired[1].second, wal.retiredPath(10));
+    ASSERT_EQ(readBack().size(), 1);
+    EXPECT_EQ(readBack()[0][1], "3");
+
+    WriteAheadLog::removeRetired(path, 2);
+    retired = WriteAheadLog::retiredLogs(path);
+    ASSERT_EQ(retired.size(), 1);
+    EXPECT_EQ(retired[0].first, 10);
+}
+
+TEST_F(WriteAheadLogTest, FailedRetireKeepsTheRecords) {
+    WriteAheadLog wal(path);
+    ASSERT_TRUE(wal.open());
+    wal.append({"LIKE", "1", "sara"});
+
+    // A non-empty directory in the way makes the rename fail
+    std::filesystem::create_directories(wal.retiredPath(3) + "/blocker");
+    EXPECT_FALSE(wal.retire(3));
+    EXPECT_EQ(wal.size(), 1);
+    EXPECT_TRUE(wal.isOpen());
+    wal.append({"LIKE", "2", "sara"});
+    wal.sync();
+    EXPECT_EQ(readBack().size(), 2);
+
+    std::filesystem::remove_all(wal.retiredPath(3));
+    EXPECT_TRUE(wal.retire(4));
+    EXPECT_EQ(wal.size(), 0);
+}
+
+TEST(AtomicFileTest, ReplacesWholeFile) {
+    std::string path = (std::filesystem::temp_directory_path() / "atomic_test.txt").string();
+    ASSERT_TRUE(AtomicFile::write(path, "first version, longer"));
+    ASSERT_TRUE(AtomicFile::write(path, "second"));
+    std::ifstream in(path, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(contents, "second");
+    EXPECT_FALSE(std::filesystem::exists(path + ".tmp"));
+    EXPECT_FALSE(AtomicFile::write(path + ".missing/dir/file", "x"));
+    std::filesystem::remove(path);
+}
+
+TEST(BackgroundWriterTest, RunsInOrderAndCoalescesByKey) {
+    BackgroundWriter writer;
+    std::mutex gate;
+    std::vector<std::string> ran;
+    std::unique_lock<std::mutex> hold(gate);
+
+    // The first job holds the worker until the rest are queued behind it
+    writer.submit("block", [&] { std::lock_guard<std::mutex> wait(gate); ran.push_back("block"); });
+    writer.submit("users", [&] { ran.push_back("users v1"); });
+    writer.submit("posts", [&] { ran.push_back("posts"); });
+    writer.submit("users", [&] { ran.push_back("users v2"); });
+    hold.unlock();
+    writer.flush();
+
+    EXPECT_EQ(writer.pending(), 0);
+    EXPECT_EQ(writer.completedJobs(), 3);
+    ASSERT_EQ(ran.size(), 3);
+    EXPECT_EQ(ran[0], "block");
+    EXPECT_EQ(ran[1], "posts");
+    EXPECT_EQ(ran[2], "users v2");
+}
+
+class BinarySnapshotTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = (std::filesystem::temp_directory_path() / "snapshot_test.bin").string();
+        ahmed = new User("ahmed", "ahmed@test.com", "pass123", "male");
+        sara = new User("sara", "sara@test.com", "pass789", "female");
+        sara->setPublic(false);
+        ahmed->addFriend(sara->getId());
+        sara->addFriend(ahmed->getId());
+        post = new Post(sara, "Hello | world", "2024-01-01 12:00:00", PostPrivacy::FRIENDS_ONLY);
+        post->addLike(ahmed->getId());
+    }
+
+    void TearDown() override {
+        delete post;
+        delete ahmed;
+        delete sara;
+        std::filesystem::remove(path);
+    }
+
+    bool writeSnapshot(const BinarySnapshot::TextSizes& sizes = {}, const BinarySnapshot::TextHashes& hashes = {}) {
+        std::vector<BinarySnapshot::Message> messages{{"ahmed", "sara", "hi", "2024-01-01 12:05:00"}};
+        return BinarySnapshot::write(path, {ahmed, sara}, {post}, messages, sizes, hashes);
+    }
+
+    std::string path;
+    User* ahmed;
+    User* sara;
+    Post* post;
+};
+
+TEST_F(BinarySnapshotTest, RoundTripsInPlace) {
+    ASSERT_TRUE(writeSnapshot({1, 2, 3, 4, 5}, {6, 7, 8, 9, 10}));
+
+    BinarySnapshot snapshot;
+    ASSERT_TRUE(snapshot.open(path));
+    EXPECT_TRUE(snapshot.matches({1, 2, 3, 4, 5}));
+    EXPECT_FALSE(snapshot.matches({1, 2, 3, 4, 6}));
+    EXPECT_TRUE(snapshot.matchesContent({6, 7, 8, 9, 10}));
+    EXPECT_FALSE(snapshot.matchesContent({6, 7, 8, 9, 11}));
+
+    ASSERT_EQ(snapshot.userCount(), 2);
+    EXPECT_EQ(snapshot.str(snapshot.user(1).username), "sara");
+    EXPECT_EQ(snapshot.str(snapshot.user(0).password), "pass123");
+    EXPECT_EQ(snapshot.user(1).flags & StorageEngine::USER_PUBLIC, 0);
+    ASSERT_EQ(snapshot.friendsOf(0).size(), 1);
+    EXPECT_EQ(*snapshot.friendsOf(0).begin(), 1);
+
+    ASSERT_EQ(snapshot.postCount(), 1);
+    EXPECT_EQ(snapshot.post(0).id, post->getId());
+    EXPECT_EQ(snapshot.post(0).author, 1);
+    EXPECT_EQ(snapshot.post(0).privacy, static_cast<std::uint32_t>(PostPrivacy::FRIENDS_ONLY));
+    EXPECT_EQ(snapshot.str(snapshot.post(0).content), "Hello | world");
+    ASSERT_EQ(snapshot.likesOf(0).size(), 1);
+    EXPECT_EQ(*snapshot.likesOf(0).begin(), 0);
+
+    ASSERT_EQ(snapshot.messageCount(), 1);
+    EXPECT_EQ(snapshot.message(0).to, "sara");
+    EXPECT_EQ(snapshot.message(0).text, "hi");
+}
+
+TEST_F(BinarySnapshotTest, RejectsCorruptFiles) {
+    ASSERT_TRUE(writeSnapshot());
+    auto size = std::filesystem::file_size(path);
+
+    // Truncated: the header's file size no longer matches
+    std::filesystem::resize_file(path, size - 1);
+    BinarySnapshot snapshot;
+    EXPECT_FALSE(snapshot.open(path));
+
+    // Bad magic
+    ASSERT_TRUE(writeSnapshot());
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.write("XXXX", 4);
+    }
+    EXPECT_FALSE(snapshot.open(path));
+    EXPECT_FALSE(snapshot.open(path + ".missing"));
+}
+
+class DelimitedReaderTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = (std::filesystem::temp_directory_path() / "delimited_test.txt").string();
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path);
+    }
+
+    void write(const std::string& contents) {
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << contents;
+    }
+
+    std::string path;
+};
+
+TEST_F(DelimitedReaderTest, SplitsFieldsAndSkipsBlankLines) {
+    write("a@test.com|ahmed|pass|male\r\n\nsara@test.com|sara|pass|female");
+    DelimitedReader reader;
+    ASSERT_TRUE(reader.open(path));
+
+    DelimitedReader::Record record;
+    ASSERT_TRUE(reader.next(record));
+    ASSERT_EQ(record.size(), 4);
+    EXPECT_EQ(record[1], "ahmed");
+    EXPECT_EQ(record[3], "male");  // '\r' dropped
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.line, 3);
+    EXPECT_EQ(record[3], "female");  // no trailing newline
+    EXPECT_FALSE(reader.next(record));
+}
+
+TEST_F(DelimitedReaderTest, LastFieldKeepsRemainder) {
+    // Long enough to go through the 16-byte scan before hitting a delimiter
+    std::string content = "a post that mentions a|b and keeps going past sixteen bytes";
+    write("7|ahmed|" + content + "|2024-01-01\n");
+    DelimitedReader reader;
+    ASSERT_TRUE(reader.open(path));
+
+    DelimitedReader::Record record;
+    ASSERT_TRUE(reader.next(record, 3));
+    ASSERT_EQ(record.size(), 3);
+    EXPECT_EQ(record[0], "7");
+    EXPECT_EQ(record[2], content + "|2024-01-01");
+}
+
+TEST_F(DelimitedReaderTest, MatchesScalarSearch) {
+    std::string text(100, 'x');
+    for (std::size_t pos : {0u, 5u, 15u, 16u, 17u, 31u, 64u, 99u}) {
+        std::string probe = text;
+        probe[pos] = pos % 2 ? '|' : '\n';
+        EXPECT_EQ(DelimitedReader::findDelimiter(probe.data(), probe.data() + probe.size(), '|'),
+                  probe.data() + pos);
+    }
+    EXPECT_EQ(DelimitedReader::findDelimiter(text.data(), text.data() + text.size(), '|'),
+              text.data() + text.size());
+}
+
+TEST_F(DelimitedReaderTest, EmptyAndMissingFiles) {
+    write("");
+    DelimitedReader reader;
+    DelimitedReader::Record record;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_FALSE(reader.next(record));
+    EXPECT_FALSE(reader.open(path + ".missing"));
+}
+
+TEST_F(DelimitedReaderTest, ParallelLoaderKeepsFileOrder) {
+    std::string contents;
+    for (int i = 0; i < 500; ++i) {
+        contents += std::to_string(i) + "|user" + std::to_string(i % 7) + "|content " + std::to_string(i) + "|2024-01-01\n";
+        if (i % 50 == 0) contents += "\nshort|line\n";  // blank and short lines are skipped
+    }
+    write(contents);
+
+    // Tiny chunks force many ranges per file across several threads
+    StartupLoader loader(4, 64);
+    std::size_t posts = loader.addFile(path, 4);
+    std::size_t pairs = loader.addFile(path, 2);
+    std::size_t missing = loader.addFile(path + ".missing", 2);
+    loader.parseAll();
+
+    ASSERT_TRUE(loader.opened(posts));
+    ASSERT_EQ(loader.rows(posts).size(), 500);
+    for (int i = 0; i < 500; ++i) {
+        EXPECT_EQ(loader.rows(posts)[i][0], std::to_string(i));
+        EXPECT_EQ(loader.rows(posts)[i][2], "content " + std::to_string(i));
+    }
+    EXPECT_EQ(loader.rows(pairs).size(), 510);
+    EXPECT_EQ(loader.rows(pairs)[1][1], "line");
+    EXPECT_FALSE(loader.opened(missing));
+    EXPECT_TRUE(loader.rows(missing).empty());
+}
+
+TEST(StartupReportTest, TimesPhasesAndForwardsResults) {
+    StartupReport report;
+    EXPECT_EQ(report.time("answer", [] { return 42; }), 42);
+    report.time("noop", [] {});
+    ASSERT_EQ(report.getPhases().size(), 2);
+    EXPECT_EQ(report.getPhases()[1].name, "noop");
+    EXPECT_GE(report.totalMilliseconds(), 0.0);
+}
+
+// Flattens every loaded record into a line, so backends can be compared
+class RecordingSink : public StorageEngine::Sink {
+public:
+    std::vector<std::string> records;
+
+    void user(const StorageEngine::UserRow& row) override {
+        records.push_back("user " + std::string(row.username) + " " + std::string(row.email) + " " +
+                          std::string(row.password) + " " + std::string(row.gender) + " " + std::to_string(row.flags));
+    }
+    void post(const StorageEngine::PostRow& row) override {
+        records.push_back("post " + std::to_string(row.id) + " " + std::string(row.author) + " " +
+                          std::to_string(static_cast<int>(row.privacy)) + " " + std::string(row.timestamp) +
+                          " " + std::string(row.content));
+    }
+    void like(const StorageEngine::LikeRow& row) override {
+        records.push_back("like " + std::to_string(row.postId) + " " + std::string(row.username));
+    }
+    void friendship(const StorageEngine::FriendshipRow& row) override {
+        records.push_back("friends " + std::string(row.user1) + " " + std::string(row.user2));
+    }
+    void message(const StorageEngine::MessageRow& row) override {
+        records.push_back("message " + std::string(row.from) + " " + std::string(row.to) + " " +
+                          std::string(row.timestamp) + " " + std::string(row.text));
+    }
+};
+
+class StorageEngineTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir = (std::filesystem::temp_directory_path() / "storage_test").string();
+        std::filesystem::remove_all(dir);
+        ahmed = new User("ahmed", "ahmed@test.com", "pass123", "male");
+        sara = new User("sara", "sara@test.com", "pass789", "female");
+        sara->setBot(true);
+        ahmed->addFriend(sara->getId());
+        sara->addFriend(ahmed->getId());
+        post = new Post(sara, "Hello | world\nsecond \\ line", "2024-01-01 12:00:00", PostPrivacy::FRIENDS_ONLY);
+        post->addLike(ahmed->getId());
+        userList = {ahmed, sara};
+        postList = {post};
+        messages = {{"ahmed", "sara", "2024-01-01 12:05:00", "hi | there"}};
+        data.users = &userList;
+        data.posts = &postList;
+        data.messages = &messages;
+    }
+
+    void TearDown() override {
+        delete post;
+        delete ahmed;
+        delete sara;
+        std::filesystem::remove_all(dir);
+    }
+
+    void writeFile(const std::string& name, const std::string& contents) {
+        std::filesystem::create_directories(dir);
+        std::ofstream(dir + "/" + name, std::ios::binary | std::ios::trunc) << contents;
+    }
+
+    std::string dir;
+    User* ahmed;
+    User* sara;
+    Post* post;
+    std::vector<User*> userList;
+    std::vector<Post*> postList;
+    std::vector<StorageEngine::MessageRow> messages;
+    StorageEngine::Dataset data;
+};
+
+TEST_F(StorageEngineTest, EscapingRoundTrips) {
+    std::string encoded, scratch;
+    TextStorage::escape("a|b\\c\nd\re", encoded);
+    EXPECT_EQ(encoded.find('|'), std::string::npos);
+    EXPECT_EQ(encoded.find('\n'), std::string::npos);
+    EXPECT_EQ(TextStorage::unescape(encoded, scratch), "a|b\\c\nd\re");
+    EXPECT_EQ(TextStorage::unescape("plain", scratch).data(), std::string_view("plain").data());
+}
+
+TEST_F(StorageEngineTest, TextRoundTripsEveryEntity) {
+    TextStorage text(dir);
+    ASSERT_TRUE(text.save(data));
+    EXPECT_EQ(TextStorage::schemaOf(text.path(TextStorage::POSTS_FILE)), TextStorage::SCHEMA_VERSION);
+
+    RecordingSink sink;
+    ASSERT_TRUE(text.load(sink));
+    std::string id = std::to_string(post->getId());
+    std::vector<std::string> expected = {
+        "user ahmed ahmed@test.com pass123 male 2",
+        "user sara sara@test.com pass789 female 3",
+        "post " + id + " sara 1 2024-01-01 12:00:00 Hello | world\nsecond \\ line",
+        "like " + id + " ahmed",
+        "friends ahmed sara",
+        "message ahmed sara 2024-01-01 12:05:00 hi | there"
+    };
+    EXPECT_EQ(sink.records, expected);
+
+    // A subset only touches its own files
+    RecordingSink users;
+    ASSERT_TRUE(text.load(users, StorageEngine::USERS));
+    EXPECT_EQ(users.records.size(), 2);
+}
+
+TEST_F(StorageEngineTest, BinaryMatchesTextAndDetectsStaleSnapshots) {
+    TextStorage text(dir);
+    BinaryStorage binary(dir + "/snapshot.bin", &text);
+    ASSERT_TRUE(text.save(data));
+    ASSERT_TRUE(binary.save(data));
+
+    RecordingSink fromText, fromBinary;
+    ASSERT_TRUE(text.load(fromText));
+    ASSERT_TRUE(binary.load(fromBinary));
+    EXPECT_EQ(fromBinary.records, fromText.records);
+
+    // Partial datasets cannot be snapshotted
+    StorageEngine::Dataset usersOnly = data;
+    usersOnly.entities = StorageEngine::USERS;
+    EXPECT_FALSE(binary.save(usersOnly));
+
+    // So does an edit that keeps the file's size (a changed password)
+    {
+        std::string users;
+        {
+            std::ifstream in(text.path(TextStorage::USERS_FILE), std::ios::binary);
+            users.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        std::size_t at = users.find("pass123");
+        ASSERT_NE(at, std::string::npos);
+        users.replace(at, 7, "pass999");
+        std::ofstream(text.path(TextStorage::USERS_FILE), std::ios::binary | std::ios::trunc) << users;
+        RecordingSink edited;
+        EXPECT_FALSE(binary.load(edited));
+        users.replace(at, 7, "pass123");
+        std::ofstream(text.path(TextStorage::USERS_FILE), std::ios::binary | std::ios::trunc) << users;
+        RecordingSink restored;
+        EXPECT_TRUE(binary.load(restored));
+    }
+
+    // Rewriting a text file invalidates the snapshot
+    messages.push_back({"sara", "ahmed", "2024-01-01 12:06:00", "hello"});
+    data.entities = StorageEngine::MESSAGES;
+    ASSERT_TRUE(text.save(data));
+    RecordingSink stale;
+    EXPECT_FALSE(binary.load(stale));
+}
+
+TEST_F(StorageEngineTest, OneSidedFriendshipsAreKept) {
+    // Only the user whose name sorts higher holds the edge
+    ahmed->removeFriend(sara->getId());
+    TextStorage text(dir);
+    BinaryStorage binary(dir + "/snapshot.bin", &text);
+    ASSERT_TRUE(text.save(data));
+    ASSERT_TRUE(binary.save(data));
+
+    RecordingSink fromText, fromBinary;
+    ASSERT_TRUE(text.load(fromText, StorageEngine::FRIENDSHIPS));
+    ASSERT_TRUE(binary.load(fromBinary, StorageEngine::FRIENDSHIPS));
+    EXPECT_EQ(fromText.records, (std::vector<std::string>{"friends ahmed sara"}));
+    EXPECT_EQ(fromBinary.records, fromText.records);
+}
+
+TEST_F(StorageEngineTest, ReadsLegacyFormats) {
+    // Both user column orders were in use, and posts had no privacy column
+    writeFile("users.txt", "ahmed@test.com|ahmed|pass123|male\nsara|sara@test.com|pass789|female\n");
+    writeFile("posts.txt", "7|sara|Hello \\o/|1735448416\nahmed|Second|2024-01-01 12:00:00|2\n");
+    writeFile("messages.txt", "ahmed|sara|hi|2024-01-01 12:05:00\n");
+
+    TextStorage text(dir);
+    RecordingSink sink;
+    ASSERT_TRUE(text.load(sink, StorageEngine::USERS | StorageEngine::POSTS | StorageEngine::MESSAGES));
+    std::vector<std::string> expected = {
+        "user ahmed ahmed@test.com pass123 male 2",
+        "user sara sara@test.com pass789 female 2",
+        "post 7 sara 0 1735448416 Hello \\o/",
+        "post -1 ahmed 2 2024-01-01 12:00:00 Second",
+        "message ahmed sara 2024-01-01 12:05:00 hi"
+    };
+    EXPECT_EQ(sink.records, expected);
+
+    RecordingSink missing;
+    EXPECT_FALSE(TextStorage(dir + "/missing").load(missing));
+}
+
+TEST_F(StorageEngineTest, SnapshotEncodedBeforeTextCommitsStillMatches) {
+    // The snapshot is encoded while the text images are still unwritten, as in
+    // a background checkpoint; it must record the sizes they will have
+    TextStorage text(dir);
+    BinaryStorage binary(dir + "/snapshot.bin", &text);
+    ASSERT_TRUE(text.save(data));
+
+    messages.push_back({"sara", "ahmed", "2024-01-01 12:06:00", "hello"});
+    StorageEngine::Dataset changed = data;
+    changed.entities = StorageEngine::MESSAGES;
+    StorageEngine::FileImages textImages, snapshotImages;
+    ASSERT_TRUE(text.encode(changed, textImages));
+    ASSERT_TRUE(binary.encode(data, snapshotImages));
+    ASSERT_EQ(textImages.size(), 1);
+
+    ASSERT_TRUE(StorageEngine::commit(textImages));
+    ASSERT_TRUE(StorageEngine::commit(snapshotImages));
+    RecordingSink sink;
+    EXPECT_TRUE(binary.load(sink));
+}
+
+TEST_F(StorageEngineTest, VersionsTrackPersistedChangesOnly) {
+    std::uint64_t saved = Versioned::now();
+    EXPECT_FALSE(ahmed->changedSince(saved));
+    EXPECT_FALSE(post->changedSince(saved));
+
+    // Friend requests and blocks are not persisted, and repeats change nothing
+    ahmed->addFriendRequest(sara->getId());
+    ahmed->addFriend(sara->getId());
+    post->addLike(ahmed->getId());
+    EXPECT_FALSE(ahmed->changedSince(saved));
+    EXPECT_FALSE(post->changedSince(saved));
+
+    ahmed->setGender("other");
+    post->removeLike(ahmed->getId());
+    EXPECT_TRUE(ahmed->changedSince(saved));
+    EXPECT_TRUE(post->changedSince(saved));
+    EXPECT_FALSE(sara->changedSince(saved));
+    EXPECT_GT(post->getVersion(), ahmed->getVersion());
+
+    // New records start out changed
+    Post fresh(sara, "new", "2024-01-02 09:00:00");
+    EXPECT_TRUE(fresh.changedSince(saved));
+    Comment* comment = fresh.addComment(ahmed, "nice");
+    saved = Versioned::now();
+    comment->addLike(sara);
+    EXPECT_TRUE(comment->changedSince(saved));
+    EXPECT_FALSE(fresh.changedSince(saved));
+}
+
+class MessageArchiveTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir = (std::filesystem::temp_directory_path() / "message_archive_test").string();
+        std::filesystem::remove_all(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    static std::vector<std::string> texts(const MessageArchive& archive, const std::string& a, const std::string& b) {
+        std::vector<std::string> result;
+        archive.read(a, b, [&](const StorageEngine::MessageRow& row) { result.emplace_back(row.text); });
+        return result;
+    }
+
+    std::string dir;
+};
+
+TEST_F(MessageArchiveTest, ReadsOnlyTheConversationsSegments) {
+    {
+        MessageArchive archive(dir);
+        EXPECT_FALSE(archive.open());
+        archive.create();
+        archive.append("ahmed", "sara", "2024-01-01 12:00:00", "hi");
+        archive.append("sara", "ahmed", "2024-01-01 12:01:00", "hello | there");
+        archive.append("ahmed", "omar", "2024-01-01 12:02:00", "yo");
+        archive.append("ahmed", "sara", "2024-01-01 12:03:00", "bye\nfor now");
+        EXPECT_EQ(archive.size(), 4);
+        EXPECT_EQ(archive.conversationCount(), 2);
+        ASSERT_TRUE(archive.writeIndex());
+        EXPECT_FALSE(archive.hasUnindexedChanges());
+        // Appended after the index was written
+        archive.append("omar", "ahmed", "2024-01-01 12:04:00", "later");
+    }
+
+    MessageArchive archive(dir);
+    ASSERT_TRUE(archive.open());
+    EXPECT_TRUE(archive.hasUnindexedChanges());  // the tail was scanned
+    EXPECT_EQ(archive.size(), 5);
+    EXPECT_EQ(texts(archive, "sara", "ahmed"),
+              (std::vector<std::string>{"hi", "hello | there", "bye\nfor now"}));
+    EXPECT_EQ(texts(archive, "ahmed", "omar"), (std::vector<std::string>{"yo", "later"}));
+    EXPECT_TRUE(texts(archive, "sara", "omar").empty());
+    EXPECT_EQ(archive.messageCount("omar", "ahmed"), 2);
+    EXPECT_EQ(archive.inboxOf("ahmed").size(), 2);
+
+    // Segments are runs of consecutive records, and cover only this chat
+    std::uint64_t bytes = 0;
+    for (const auto& segment : archive.segmentsOf("ahmed", "sara")) bytes += segment.length;
+    EXPECT_GT(bytes, 0u);
+    EXPECT_LT(archive.segmentsOf("ahmed", "sara").size(), 4u);
+}
+
+TEST_F(MessageArchiveTest, RecoversFromTornAndTruncatedBuckets) {
+    std::string bucket;
+    {
+        MessageArchive archive(dir);
+        archive.create();
+        archive.append("ahmed", "sara", "1", "one");
+        archive.append("ahmed", "sara", "2", "two");
+        ASSERT_TRUE(archive.writeIndex());
+    }
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        if (entry.path().extension() == ".log") bucket = entry.path().string();
+    }
+    ASSERT_FALSE(bucket.empty());
+
+    // A torn record from a crash is dropped
+    {
+        std::ofstream out(bucket, std::ios::binary | std::ios::app);
+        out << "ahmed|sara|3|thr";
+    }
+    {
+        MessageArchive archive(dir);
+        ASSERT_TRUE(archive.open());
+        EXPECT_EQ(texts(archive, "ahmed", "sara"), (std::vector<std::string>{"one", "two"}));
+        archive.append("sara", "ahmed", "4", "four");
+    }
+    {
+        MessageArchive archive(dir);
+        ASSERT_TRUE(archive.open());
+        EXPECT_EQ(texts(archive, "ahmed", "sara"), (std::vector<std::string>{"one", "two", "four"}));
+    }
+
+    // A bucket shorter than the index says is indexed afresh
+    std::filesystem::resize_file(bucket, 0);
+    MessageArchive archive(dir);
+    ASSERT_TRUE(archive.open());
+    EXPECT_EQ(archive.size(), 0);
+    EXPECT_TRUE(texts(archive, "ahmed", "sara").empty());
+}
+
+TEST_F(MessageArchiveTest, InboxOrdersChatsByLastActivityWithUnreadCounts) {
+    {
+        MessageArchive archive(dir);
+        archive.create();
+        archive.append("omar", "ahmed", "2024-01-01 09:00:00", "morning");
+        archive.append("sara", "ahmed", "2024-01-01 10:00:00", "hi");
+        archive.append("sara", "ahmed", "2024-01-01 10:05:00", std::string(100, 'x'));
+        archive.append("ahmed", "omar", "2024-01-01 11:00:00", "reply\nsecond line");
+        archive.append("sara", "omar", "2024-01-01 12:00:00", "not ahmed's");
+
+        auto inbox = archive.inboxOf("ahmed");
+        ASSERT_EQ(inbox.size(), 2);
+        EXPECT_EQ(inbox[0].peer, "omar");
+        EXPECT_EQ(inbox[0].lastFrom, "ahmed");
+        EXPECT_EQ(inbox[0].preview, "reply second line");
+        // Replying without opening the chat leaves omar's message unread
+        EXPECT_EQ(inbox[0].unread, 2);
+        EXPECT_EQ(inbox[1].peer, "sara");
+        EXPECT_EQ(inbox[1].unread, 2);
+        EXPECT_EQ(inbox[1].preview, std::string(MessageArchive::PREVIEW_LENGTH, 'x') + "...");
+        EXPECT_EQ(archive.unreadCount("ahmed"), 4);
+        EXPECT_EQ(archive.unreadCount("omar"), 2);
+        EXPECT_EQ(archive.inboxOf("sara", 1).size(), 1);
+        EXPECT_EQ(archive.inboxOf("sara", 1)[0].peer, "omar");
+
+        EXPECT_TRUE(archive.markRead("ahmed", "sara"));
+        EXPECT_FALSE(archive.markRead("ahmed", "sara"));
+        ASSERT_TRUE(archive.writeIndex());
+        // Caught up, so his own reply does not count as unread
+        archive.append("ahmed", "sara", "2024-01-01 12:30:00", "here");
+        archive.append("sara", "ahmed", "2024-01-01 13:00:00", "still there?");
+    }
+
+    // The index restores read markers and previews; the tail updates them
+    MessageArchive archive(dir);
+    ASSERT_TRUE(archive.open());
+    auto inbox = archive.inboxOf("ahmed");
+    ASSERT_EQ(inbox.size(), 2);
+    EXPECT_EQ(inbox[0].peer, "sara");
+    EXPECT_EQ(inbox[0].preview, "still there?");
+    EXPECT_EQ(inbox[0].unread, 1);
+    EXPECT_EQ(inbox[1].preview, "reply second line");
+    EXPECT_EQ(archive.unreadCount("omar"), 2);
+}
+
+TEST_F(MessageArchiveTest, ReplayAppendsOnlyWhatIsNotStored) {
+    MessageArchive archive(dir);
+    archive.create();
+    archive.append("ahmed", "sara", "2024-01-01 12:00:00", "hi");
+    archive.append("sara", "ahmed", "2024-01-01 12:01:00", "hello");
+
+    EXPECT_FALSE(archive.appendUnlessStored("ahmed", "sara", "2024-01-01 12:00:00", "hi"));
+    EXPECT_FALSE(archive.appendUnlessStored("sara", "ahmed", "2024-01-01 12:01:00", "hello"));
+    // Older than the latest message but never archived
+    EXPECT_TRUE(archive.appendUnlessStored("ahmed", "sara", "2024-01-01 11:59:00", "earlier"));
+    // Same second, but another sender or text is a new message
+    EXPECT_TRUE(archive.appendUnlessStored("ahmed", "sara", "2024-01-01 12:01:00", "hello"));
+    EXPECT_TRUE(archive.appendUnlessStored("sara", "ahmed", "2024-01-01 12:01:00", "and more"));
+    // One stored copy absorbs one replayed copy
+    EXPECT_TRUE(archive.appendUnlessStored("ahmed", "sara", "2024-01-01 12:00:00", "hi"));
+    EXPECT_EQ(archive.messageCount("ahmed", "sara"), 6);
+    archive.endReplay();
+
+    // Replaying the same log again adds nothing
+    EXPECT_FALSE(archive.appendUnlessStored("ahmed", "sara", "2024-01-01 11:59:00", "earlier"));
+    EXPECT_FALSE(archive.appendUnlessStored("ahmed", "sara", "2024-01-01 12:01:00", "hello"));
+    EXPECT_FALSE(archive.appendUnlessStored("ahmed", "sara", "2024-01-01 12:00:00", "hi"));
+    EXPECT_FALSE(archive.appendUnlessStored("ahmed", "sara", "2024-01-01 12:00:00", "hi"));
+    EXPECT_EQ(archive.messageCount("ahmed", "sara"), 6);
+    archive.endReplay();
+}
+
+TEST_F(MessageArchiveTest, SkipsIndexLinesThatDoNotParse) {
+    {
+        MessageArchive archive(dir);
+        archive.create();
+        archive.append("ahmed", "sara", "2024-01-01 12:00:00", "hi");
+        ASSERT_TRUE(archive.writeIndex());
+    }
+    {
+        std::ofstream out(dir + "/index", std::ios::binary | std::ios::app);
+        out << "S|ahmed|sara|99999999999999999999999|1|1\n"
+            << "B|7|-3\n"
+            << "C|ahmed|omar|0|ahmed|x|1|\n";
+    }
+
+    MessageArchive archive(dir);
+    ASSERT_TRUE(archive.open());
+    EXPECT_EQ(archive.size(), 1);
+    EXPECT_EQ(archive.conversationCount(), 1);
+    EXPECT_EQ(texts(archive, "sara", "ahmed"), (std::vector<std::string>{"hi"}));
+}
@@ -137,3 +137,52 @@ TEST_F(PostCommentTest, NestedComments) {
     
     delete parentComment;
 }
+
+TEST(ObjectPoolTest, ReusesSlotsAndGrowsBySlabs) {
+    struct Item { long long a, b; };
+    ObjectPool<Item> pool;
+    if (!ObjectPool<Item>::ENABLED) GTEST_SKIP() << "pool is bypassed under AddressSanitizer";
+
+    void* first = pool.allocate();
+    void* second = pool.allocate();
+    EXPECT_NE(first, second);
+    EXPECT_EQ(pool.liveCount(), 2);
+    EXPECT_EQ(pool.slabCount(), 1);
+
+    // The most recently freed slot is handed out next
+    pool.deallocate(first);
+    EXPECT_EQ(pool.allocate(), first);
+
+    // Slabs double, so many objects take few allocations
+    std::vector<void*> items;
+    for (int i = 0; i < 10000; ++i) items.push_back(pool.allocate());
+    EXPECT_EQ(pool.liveCount(), 10002);
+    EXPECT_GE(pool.capacity(), 10002);
+    EXPECT_LE(pool.slabCount(), 9);
+    for (void* item : items) pool.deallocate(item);
+    pool.deallocate(first);
+    pool.deallocate(second);
+    EXPECT_EQ(pool.liveCount(), 0);
+
+    // Other sizes (derived classes) bypass the slabs
+    std::size_t capacity = pool.capacity();
+    void* larger = pool.allocate(sizeof(Item) * 2);
+    EXPECT_EQ(pool.liveCount(), 0);
+    pool.deallocate(larger, sizeof(Item) * 2);
+    EXPECT_EQ(pool.capacity(), capacity);
+}
+
+TEST_F(PostCommentTest, PostsAndCommentsComeFromTheirPools) {
+    if (!ObjectPool<Post>::ENABLED) GTEST_SKIP() << "pool is bypassed under AddressSanitizer";
+    std::size_t posts = ObjectPool<Post>::shared().liveCount();
+    std::size_t comments = ObjectPool<Comment>::shared().liveCount();
+
+    Post* extra = new Post(user2, "Pooled", "2024-01-01 12:30:00");
+    extra->addComment(user1, "First")->addReply(user2, "Reply");
+    EXPECT_EQ(ObjectPool<Post>::shared().liveCount(), posts + 1);
+    EXPECT_EQ(ObjectPool<Comment>::shared().liveCount(), comments + 2);
+
+    delete extra;
+    EXPECT_EQ(ObjectPool<Post>::shared().liveCount(), posts);
+    EXPECT_EQ(ObjectPool<Comment>::shared().liveCount(), comments);
+}
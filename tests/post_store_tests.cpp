@@ -0,0 +1,440 @@
+#include <gtest/gtest.h>
+#include "../include/PostStore.h"
+#include "../include/PostSearchIndex.h"
+#include "../include/Post.h"
+#include "../include/User.h"
+#include "../include/UserDirectory.h"
+#include "../include/FeedService.h"
+#include "../include/Timestamp.h"
+#include "../include/TimelineCache.h"
+
+class PostStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        author = new User("author", "author@test.com", "pass123");
+        for (int i = 0; i < 5; ++i) {
+            created.push_back(store.addPost(
+                std::make_unique<Post>(author, "Post " + std::to_string(i), "2024-01-01 12:00:00")));
+        }
+    }
+
+    void TearDown() override {
+        store.clear();
+        delete author;
+    }
+
+    PostStore store;
+    User* author;
+    std::vector<Post*> created;
+};
+
+TEST_F(PostStoreTest, LookupById) {
+    EXPECT_EQ(store.size(), 5);
+    for (auto* post : created) {
+        EXPECT_EQ(store.findById(post->getId()), post);
+    }
+    EXPECT_EQ(store.findById(-1), nullptr);
+    EXPECT_EQ(store.findById(created.back()->getId() + 1000), nullptr);
+}
+
+TEST_F(PostStoreTest, RejectsDuplicateIds) {
+    EXPECT_EQ(store.addPost(std::make_unique<Post>(created[0]->getId(), author, "Copy", "2024-01-01 12:00:00")),
+              nullptr);
+    EXPECT_EQ(store.addPost(nullptr), nullptr);
+    EXPECT_EQ(store.size(), 5);
+    EXPECT_EQ(store.findById(created[0]->getId())->getContent(), "Post 0");
+}
+
+TEST_F(PostStoreTest, LookupStaysCorrectAfterRemoval) {
+    int removedId = created[1]->getId();
+    std::unique_ptr<Post> removed = store.removePost(created[1]);
+    ASSERT_EQ(removed.get(), created[1]);
+    EXPECT_EQ(store.removePost(created[1]), nullptr);
+    EXPECT_EQ(store.findById(removedId), nullptr);
+    EXPECT_EQ(store.findById(created[2]->getId()), created[2]);
+    EXPECT_EQ(store.size(), 4);
+    EXPECT_EQ(store.getPosts()[1], created[2]);
+}
+
+TEST_F(PostStoreTest, RestoredIdsAreKeptAndSkipped) {
+    int savedId = created.back()->getId() + 100;
+    Post* restored = store.addPost(std::make_unique<Post>(savedId, author, "Restored", "2024-01-02 08:00:00"));
+    ASSERT_NE(restored, nullptr);
+    EXPECT_EQ(restored->getId(), savedId);
+    EXPECT_EQ(store.findById(savedId), restored);
+
+    // New posts are numbered after the highest restored id
+    Post next(author, "Next", "2024-01-02 09:00:00");
+    EXPECT_GT(next.getId(), savedId);
+}
+
+TEST_F(PostStoreTest, FarOffIdsDoNotGrowTheTable) {
+    // An id far past the others, as a corrupt posts.txt or log could hold
+    int farId = created.back()->getId() + 10000000;
+    Post* far = store.addPost(std::make_unique<Post>(farId, author, "Far", "2024-01-01 13:00:00",
+                                                     PostPrivacy::FRIENDS_ONLY));
+    ASSERT_NE(far, nullptr);
+    EXPECT_LT(store.tableSize(), 100000u);
+    EXPECT_EQ(store.findById(farId), far);
+    EXPECT_EQ(store.addPost(std::make_unique<Post>(farId, author, "Copy", "2024-01-01 13:00:00")), nullptr);
+    EXPECT_EQ(store.authorOf(farId), author->getId());
+    EXPECT_EQ(store.epochOf(farId), far->getEpoch());
+    EXPECT_EQ(store.privacyOf(farId), PostPrivacy::FRIENDS_ONLY);
+    far->setPrivacy(PostPrivacy::PUBLIC);
+    EXPECT_EQ(store.privacyOf(farId), PostPrivacy::PUBLIC);
+
+    // Scans include it, in id order and newest first
+    std::int64_t noon = created[0]->getEpoch();
+    std::vector<int> ids = store.idsBetween(noon, noon + 7200, PostPrivacy::PUBLIC);
+    ASSERT_EQ(ids.size(), 6);
+    EXPECT_EQ(ids.back(), farId);
+    EXPECT_EQ(store.postsBetween(noon, noon + 7200, PostPrivacy::PUBLIC).front(), far);
+
+    std::unique_ptr<Post> removed = store.removePost(far);
+    EXPECT_EQ(removed.get(), far);
+    EXPECT_EQ(store.findById(farId), nullptr);
+    EXPECT_EQ(store.size(), 5);
+}
+
+TEST_F(PostStoreTest, TableGrowthAbsorbsSideMapIds) {
+    PostStore local;
+    Post* early = local.addPost(std::make_unique<Post>(3000, author, "Early", "2024-01-01 12:00:00"));
+    EXPECT_LT(local.tableSize(), 3000u);
+    for (int id = 0; id < 1300; ++id) {
+        local.addPost(std::make_unique<Post>(id, author, "Post", "2024-01-01 12:00:00"));
+    }
+    // Enough posts now that the table reaches past 3000
+    Post* late = local.addPost(std::make_unique<Post>(4000, author, "Late", "2024-01-01 12:00:00"));
+    EXPECT_GT(local.tableSize(), 3000u);
+    EXPECT_EQ(local.findById(3000), early);
+    EXPECT_EQ(local.findById(4000), late);
+    EXPECT_EQ(local.authorOf(3000), author->getId());
+
+    std::int64_t noon = early->getEpoch();
+    std::vector<int> ids = local.idsBetween(noon, noon + 1, PostPrivacy::PUBLIC);
+    ASSERT_EQ(ids.size(), 1302);
+    EXPECT_TRUE(std::is_sorted(ids.begin(), ids.end()));
+    EXPECT_EQ(local.removePost(early).get(), early);
+    EXPECT_EQ(local.findById(3000), nullptr);
+}
+
+TEST_F(PostStoreTest, ColumnsMirrorPostsAndFilterByTime) {
+    Post* early = store.addPost(std::make_unique<Post>(author, "Early", "2024-01-01 08:00:00"));
+    Post* hidden = store.addPost(std::make_unique<Post>(author, "Hidden", "2024-01-01 18:00:00",
+                                                        PostPrivacy::PRIVATE));
+    EXPECT_EQ(store.authorOf(early->getId()), author->getId());
+    EXPECT_EQ(store.epochOf(early->getId()), early->getEpoch());
+    EXPECT_EQ(store.privacyOf(hidden->getId()), PostPrivacy::PRIVATE);
+    EXPECT_EQ(store.authorOf(-1), INVALID_USER_ID);
+
+    std::int64_t noon = created[0]->getEpoch();
+    std::int64_t day = Timestamp::toEpoch("2024-01-01 00:00:00");
+    // Half-open range, newest first; equal times fall back to the newer id
+    auto afternoon = store.postsBetween(noon, day + 86400, PostPrivacy::PRIVATE);
+    ASSERT_EQ(afternoon.size(), 6);
+    EXPECT_EQ(afternoon[0], hidden);
+    EXPECT_EQ(afternoon[1], created[4]);
+    EXPECT_EQ(afternoon.back(), created[0]);
+    EXPECT_EQ(store.postsBetween(day, noon, PostPrivacy::PRIVATE), (std::vector<Post*>{early}));
+    EXPECT_EQ(store.postsBetween(noon + 1, day + 86400, PostPrivacy::FRIENDS_ONLY).size(), 0);
+
+    // Privacy changes and removals reach the columns
+    hidden->setPrivacy(PostPrivacy::PUBLIC);
+    EXPECT_EQ(store.postsBetween(noon + 1, day + 86400, PostPrivacy::PUBLIC), (std::vector<Post*>{hidden}));
+    std::unique_ptr<Post> removed = store.removePost(hidden);
+    EXPECT_EQ(store.authorOf(removed->getId()), INVALID_USER_ID);
+    EXPECT_TRUE(store.idsBetween(noon + 1, day + 86400, PostPrivacy::PRIVATE).empty());
+    removed->setPrivacy(PostPrivacy::PRIVATE);  // no longer reported to the store
+}
+
+class PostSearchIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        author = new User("author", "author@test.com", "pass123");
+        add("Beautiful day for coding! #programming #cpp");
+        add("Working on some cool C++ stuff! #coding");
+        add("Coding all day, coding all night");
+        add("What a beautiful morning");
+    }
+
+    void TearDown() override {
+        for (auto* post : created) delete post;
+        delete author;
+    }
+
+    Post* add(const std::string& content) {
+        Post* post = new Post(author, content, "2024-01-01 12:00:00");
+        created.push_back(post);
+        index.addPost(post);
+        return post;
+    }
+
+    int id(std::size_t i) const { return created[i]->getId(); }
+
+    PostSearchIndex index;
+    User* author;
+    std::vector<Post*> created;
+};
+
+TEST_F(PostSearchIndexTest, CaseFoldedAndQueries) {
+    EXPECT_EQ(index.search("BEAUTIFUL"), (std::vector<int>{id(3), id(0)}));
+    EXPECT_EQ(index.search("beautiful day"), (std::vector<int>{id(0)}));
+    EXPECT_TRUE(index.search("beautiful night").empty());
+}
+
+TEST_F(PostSearchIndexTest, HashtagsAreTerms) {
+    EXPECT_EQ(index.search("#cpp"), (std::vector<int>{id(0)}));
+    EXPECT_EQ(index.search("#coding"), (std::vector<int>{id(1)}));
+    // The bare word also matches hashtags; the post using it twice ranks first
+    auto coding = index.search("coding");
+    ASSERT_EQ(coding.size(), 3);
+    EXPECT_EQ(coding[0], id(2));
+}
+
+TEST_F(PostSearchIndexTest, OrAndPhraseQueries) {
+    auto either = index.search("morning OR #cpp");
+    EXPECT_EQ(either.size(), 2);
+    EXPECT_EQ(index.search("\"all night\""), (std::vector<int>{id(2)}));
+    EXPECT_TRUE(index.search("\"night all\"").empty());
+    EXPECT_EQ(index.search("\"beautiful day\" #cpp"), (std::vector<int>{id(0)}));
+}
+
+TEST_F(PostSearchIndexTest, RemovedPostsDisappear) {
+    index.removePost(created[0]);
+    EXPECT_EQ(index.search("beautiful"), (std::vector<int>{id(3)}));
+    EXPECT_TRUE(index.search("#cpp").empty());
+    EXPECT_EQ(index.documentCount(), 3);
+    EXPECT_EQ(index.search("coding", 1).size(), 1);
+}
+
+TEST(TimestampTest, ParsesAllStoredFormats) {
+    EXPECT_EQ(Timestamp::toEpoch("1704110400"), 1704110400);
+    EXPECT_EQ(Timestamp::toEpoch("2024-01-01 12:00:00"), 1704110400);
+    EXPECT_EQ(Timestamp::toEpoch("2024-01-01 12:00"), 1704110400);
+    EXPECT_EQ(Timestamp::toEpoch("2024-01-01"), 1704067200);
+    EXPECT_EQ(Timestamp::toEpoch("Mon Jan  1 12:00:00 2024"), 1704110400);
+    EXPECT_EQ(Timestamp::toEpoch("not a date"), 0);
+    EXPECT_EQ(Timestamp::toEpoch(""), 0);
+}
+
+class FeedServiceTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        viewer = new User("viewer", "viewer@test.com", "pass");
+        friend1 = new User("friend1", "friend1@test.com", "pass");
+        friend2 = new User("friend2", "friend2@test.com", "pass");
+        stranger = new User("stranger", "stranger@test.com", "pass");
+        for (User* user : {viewer, friend1, friend2, stranger}) directory.addUser(user);
+        befriend(viewer, friend1);
+        befriend(viewer, friend2);
+
+        // Interleaved timestamps across authors; the store owns the posts
+        post(friend1, "2024-01-01 10:00:00");
+        post(viewer, "2024-01-01 11:00:00");
+        post(friend2, "2024-01-01 12:00:00");
+        post(friend1, "2024-01-01 13:00:00", PostPrivacy::FRIENDS_ONLY);
+        post(friend2, "2024-01-01 14:00:00", PostPrivacy::PRIVATE);
+        post(stranger, "2024-01-01 15:00:00");
+        post(friend1, "2024-01-01 09:00:00");  // back-dated, inserted out of order
+    }
+
+    void TearDown() override {
+        store.clear();
+        for (User* user : {viewer, friend1, friend2, stranger}) delete user;
+    }
+
+    static void befriend(User* a, User* b) {
+        a->addFriend(b->getId());
+        b->addFriend(a->getId());
+    }
+
+    Post* post(User* author, const std::string& timestamp, PostPrivacy privacy = PostPrivacy::PUBLIC) {
+        Post* p = store.addPost(std::make_unique<Post>(author, author->getUsername() + " at " + timestamp,
+                                                       timestamp, privacy));
+        author->addPost(p);
+        return p;
+    }
+
+    static std::vector<std::string> times(const FeedPage& page) {
+        std::vector<std::string> result;
+        for (const Post* p : page.posts) result.push_back(p->getTimestamp().substr(11, 2));
+        return result;
+    }
+
+    UserDirectory directory;
+    PostStore store;
+    User* viewer;
+    User* friend1;
+    User* friend2;
+    User* stranger;
+};
+
+TEST_F(FeedServiceTest, MergesFriendsAndOwnPostsNewestFirst) {
+    FeedService feed(directory);
+    FeedPage page = feed.getFeed(*viewer, FeedCursor(), 10);
+    // Private post (14h) and the stranger's post (15h) are excluded
+    EXPECT_EQ(times(page), (std::vector<std::string>{"13", "12", "11", "10", "09"}));
+    EXPECT_FALSE(page.hasMore);
+}
+
+TEST_F(FeedServiceTest, CursorPaginationCoversFeedOnce) {
+    FeedService feed(directory);
+    FeedPage first = feed.getFeed(*viewer, FeedCursor(), 2);
+    EXPECT_EQ(times(first), (std::vector<std::string>{"13", "12"}));
+    ASSERT_TRUE(first.hasMore);
+
+    FeedPage second = feed.getFeed(*viewer, first.next, 2);
+    EXPECT_EQ(times(second), (std::vector<std::string>{"11", "10"}));
+
+    FeedPage third = feed.getFeed(*viewer, second.next, 2);
+    EXPECT_EQ(times(third), (std::vector<std::string>{"09"}));
+    EXPECT_FALSE(third.hasMore);
+}
+
+TEST_F(FeedServiceTest, BlockingAndRestrictionFilter) {
+    FeedService feed(directory);
+    friend1->restrictFriend(viewer->getId());
+    // Restricted friends lose friends-only posts but keep public ones
+    EXPECT_EQ(times(feed.getFeed(*viewer, FeedCursor(), 10)),
+              (std::vector<std::string>{"12", "11", "10", "09"}));
+
+    friend2->blockUser(viewer->getId());
+    EXPECT_EQ(times(feed.getFeed(*viewer, FeedCursor(), 10)),
+              (std::vector<std::string>{"11", "10", "09"}));
+}
+
+class TimelineCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        viewer = addUser("viewer");
+        quiet = addUser("quiet");
+        popular = addUser("popular");
+        befriend(viewer, quiet);
+        befriend(viewer, popular);
+        // Push popular over the fan-out threshold of 2
+        for (int i = 0; i < 3; ++i) befriend(popular, addUser("fan" + std::to_string(i)));
+
+        for (int hour = 0; hour < 6; ++hour) {
+            post(hour % 2 ? quiet : popular, hour);
+        }
+    }
+
+    void TearDown() override {
+        store.clear();
+        for (User* user : created) delete user;
+    }
+
+    User* addUser(const std::string& name) {
+        User* user = new User(name, name + "@test.com", "pass");
+        directory.addUser(user);
+        created.push_back(user);
+        return user;
+    }
+
+    static void befriend(User* a, User* b) {
+        a->addFriend(b->getId());
+        b->addFriend(a->getId());
+    }
+
+    Post* post(User* author, int hour) {
+        std::string timestamp = "2024-01-01 " + std::string(hour < 10 ? "0" : "") + std::to_string(hour) + ":00:00";
+        Post* p = store.addPost(std::make_unique<Post>(author, author->getUsername(), timestamp));
+        author->addPost(p);
+        cache.onPostCreated(*p);
+        return p;
+    }
+
+    // Walks every page and returns the post ids in order
+    template <typename Source>
+    static std::vector<int> drain(Source&& getPage, std::size_t pageSize) {
+        std::vector<int> ids;
+        FeedCursor cursor;
+        for (int guard = 0; guard < 100; ++guard) {
+            FeedPage page = getPage(cursor, pageSize);
+            for (const Post* p : page.posts) ids.push_back(p->getId());
+            if (!page.hasMore) break;
+            cursor = page.next;
+        }
+        return ids;
+    }
+
+    std::vector<int> expected() {
+        FeedService feed(directory);
+        return drain([&](const FeedCursor& c, std::size_t n) { return feed.getFeed(*viewer, c, n); }, 100);
+    }
+
+    std::vector<int> cached(std::size_t pageSize) {
+        return drain([&](const FeedCursor& c, std::size_t n) { return cache.getFeed(*viewer, c, n); }, pageSize);
+    }
+
+    UserDirectory directory;
+    PostStore store;
+    TimelineCache cache{directory, store, 3, 2};
+    std::vector<User*> created;
+    User* viewer;
+    User* quiet;
+    User* popular;
+};
+
+TEST_F(TimelineCacheTest, MatchesUncachedFeed) {
+    EXPECT_TRUE(cache.isHot(*popular));
+    EXPECT_FALSE(cache.isHot(*quiet));
+    EXPECT_FALSE(cache.isCached(viewer->getId()));
+
+    EXPECT_EQ(cached(2), expected());
+    EXPECT_TRUE(cache.isCached(viewer->getId()));
+}
+
+TEST_F(TimelineCacheTest, FanOutOnWriteAndReadMerge) {
+    cached(2);  // warm the viewer's timeline
+
+    Post* fromQuiet = post(quiet, 10);
+    Post* fromPopular = post(popular, 11);
+    FeedPage page = cache.getFeed(*viewer, FeedCursor(), 2);
+    ASSERT_EQ(page.posts.size(), 2);
+    EXPECT_EQ(page.posts[0], fromPopular);
+    EXPECT_EQ(page.posts[1], fromQuiet);
+
+    // Paging past the ring's capacity falls back to a full merge
+    for (int hour = 12; hour < 18; ++hour) post(quiet, hour);
+    EXPECT_EQ(cached(4), expected());
+}
+
+TEST_F(TimelineCacheTest, BotPostsAreMergedAtReadTime) {
+    User* bot = addUser("bot");
+    bot->setBot(true);
+    befriend(viewer, bot);
+
+    // Room to spare, so a post fanned out would show in the ring's size
+    TimelineCache roomy(directory, store, 100, 2);
+    roomy.getFeed(*viewer);
+    std::size_t ring = roomy.ringSize(viewer->getId());
+    ASSERT_GT(ring, 0u);
+
+    // Only one friend, yet never fanned out on write
+    Post* fromBot = post(bot, 20);
+    roomy.onPostCreated(*fromBot);
+    EXPECT_TRUE(roomy.isHot(*bot));
+    EXPECT_EQ(roomy.ringSize(viewer->getId()), ring);
+    EXPECT_EQ(roomy.getFeed(*viewer, FeedCursor(), 1).posts.front(), fromBot);
+
+    Post* fromQuiet = post(quiet, 21);
+    roomy.onPostCreated(*fromQuiet);
+    EXPECT_EQ(roomy.ringSize(viewer->getId()), ring + 1);
+}
+
+TEST_F(TimelineCacheTest, DeletionsAndFriendshipChanges) {
+    cached(2);
+    Post* gone = post(quiet, 12);
+    quiet->removePost(gone);
+    store.removePost(gone);
+    EXPECT_EQ(cached(2), expected());
+
+    quiet->removeFriend(viewer->getId());
+    viewer->removeFriend(quiet->getId());
+    EXPECT_EQ(cached(2), expected());
+
+    befriend(viewer, quiet);
+    cache.invalidate(viewer->getId());
+    EXPECT_EQ(cached(5), expected());
+}
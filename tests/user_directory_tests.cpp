@@ -0,0 +1,285 @@
+#include <gtest/gtest.h>
+#include <iterator>
+#include "../include/UserDirectory.h"
+#include "../include/User.h"
+#include "../include/StringInterner.h"
+#include "../include/IdSet.h"
+#include "../include/MutualFriends.h"
+#include "../include/Exceptions.h"
+
+class UserDirectoryTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        user1 = new User("ahmed", "ahmed@test.com", "pass123");
+        user2 = new User("mohamed", "mohamed@test.com", "pass456");
+        directory.addUser(user1);
+        directory.addUser(user2);
+    }
+
+    void TearDown() override {
+        delete user1;
+        delete user2;
+    }
+
+    UserDirectory directory;
+    User* user1;
+    User* user2;
+};
+
+TEST_F(UserDirectoryTest, LookupByUsernameAndEmail) {
+    EXPECT_EQ(directory.findByUsername("ahmed"), user1);
+    EXPECT_EQ(directory.findByEmail("mohamed@test.com"), user2);
+    EXPECT_EQ(directory.findByUsername("nobody"), nullptr);
+    EXPECT_EQ(directory.size(), 2);
+}
+
+TEST_F(UserDirectoryTest, RejectsDuplicates) {
+    User* sameName = new User("ahmed", "other@test.com", "pass");
+    User* sameEmail = new User("other", "ahmed@test.com", "pass");
+    EXPECT_FALSE(directory.addUser(sameName));
+    EXPECT_FALSE(directory.addUser(sameEmail));
+    EXPECT_EQ(directory.size(), 2);
+    delete sameName;
+    delete sameEmail;
+}
+
+TEST_F(UserDirectoryTest, SettersKeepIndexesConsistent) {
+    user1->setUsername("ahmed2");
+    user1->setEmail("ahmed2@test.com");
+    EXPECT_EQ(directory.findByUsername("ahmed"), nullptr);
+    EXPECT_EQ(directory.findByUsername("ahmed2"), user1);
+    EXPECT_EQ(directory.findByEmail("ahmed@test.com"), nullptr);
+    EXPECT_EQ(directory.findByEmail("ahmed2@test.com"), user1);
+
+    // Renaming onto an existing username must fail and leave the user untouched
+    EXPECT_THROW(user1->setUsername("mohamed"), UserAlreadyExistsException);
+    EXPECT_EQ(user1->getUsername(), "ahmed2");
+}
+
+TEST_F(UserDirectoryTest, RemovalAndDestruction) {
+    EXPECT_TRUE(directory.removeUser(user2));
+    EXPECT_EQ(directory.findByUsername("mohamed"), nullptr);
+    EXPECT_EQ(directory.findByEmail("mohamed@test.com"), nullptr);
+    EXPECT_FALSE(directory.removeUser(user2));
+
+    // Deleting a registered user unregisters it
+    User* temp = new User("temp", "temp@test.com", "pass");
+    directory.addUser(temp);
+    delete temp;
+    EXPECT_EQ(directory.findByUsername("temp"), nullptr);
+    EXPECT_EQ(directory.size(), 1);
+}
+
+TEST(StringInternerTest, InternIsStableAndDense) {
+    StringInterner interner;
+    std::uint32_t a = interner.intern("alice");
+    std::uint32_t b = interner.intern("bob");
+    EXPECT_EQ(interner.intern("alice"), a);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(interner.str(b), "bob");
+    EXPECT_EQ(interner.find("carol"), StringInterner::npos);
+    EXPECT_EQ(interner.size(), 2);
+
+    interner.rename(a, "alice2");
+    EXPECT_EQ(interner.find("alice2"), a);
+    EXPECT_EQ(interner.find("alice"), StringInterner::npos);
+
+    // A name interned under another id is not taken over
+    EXPECT_THROW(interner.rename(a, "bob"), std::invalid_argument);
+    EXPECT_EQ(interner.find("bob"), b);
+    EXPECT_EQ(interner.str(a), "alice2");
+    interner.rename(a, "alice2");  // renaming to its own name is fine
+}
+
+TEST_F(UserDirectoryTest, RelationshipsAreStoredAsIds) {
+    user1->addFriend(user2->getUsername());
+    ASSERT_EQ(user1->getFriendIds().size(), 1);
+    EXPECT_EQ(user1->getFriendIds()[0], user2->getId());
+    EXPECT_EQ(user1->getFriends()[0], "mohamed");
+
+    // Renaming keeps the edge, and the username wrappers follow the new name
+    user2->setUsername("mohamed2");
+    EXPECT_TRUE(user1->isFriend("mohamed2"));
+    EXPECT_FALSE(user1->isFriend("mohamed"));
+    EXPECT_EQ(User::nameOf(user2->getId()), "mohamed2");
+
+    // A name only known as someone's friend still belongs to its id
+    user1->addFriend(std::string("ghost"));
+    UserId ghost = User::findId("ghost");
+    EXPECT_THROW(user2->setUsername("ghost"), UserAlreadyExistsException);
+    EXPECT_EQ(User::nameOf(user2->getId()), "mohamed2");
+    EXPECT_EQ(User::findId("ghost"), ghost);
+    EXPECT_EQ(directory.findByUsername("mohamed2"), user2);
+    EXPECT_EQ(directory.findByUsername("ghost"), nullptr);
+
+    // Neither the interner nor the directory changes when the name is taken
+    EXPECT_THROW(user2->setUsername(user1->getUsername()), UserAlreadyExistsException);
+    EXPECT_EQ(User::nameOf(user2->getId()), "mohamed2");
+    EXPECT_EQ(directory.findByUsername(user1->getUsername()), user1);
+    EXPECT_EQ(directory.findByUsername("mohamed2"), user2);
+}
+
+TEST(IdSetTest, SortedMembership) {
+    IdSet set;
+    EXPECT_TRUE(set.insert(7));
+    EXPECT_TRUE(set.insert(3));
+    EXPECT_FALSE(set.insert(7));
+    EXPECT_TRUE(set.insert(5));
+    EXPECT_EQ(set.size(), 3);
+    EXPECT_EQ(set[0], 3);
+    EXPECT_EQ(set[2], 7);
+    EXPECT_TRUE(set.contains(5));
+    EXPECT_TRUE(set.erase(5));
+    EXPECT_FALSE(set.contains(5));
+    EXPECT_FALSE(set.erase(5));
+}
+
+TEST(IdSetTest, IntersectionMatchesReference) {
+    // Balanced sizes exercise the block kernel, skewed sizes the galloping path
+    const std::pair<UserId, UserId> shapes[] = {{2, 3}, {3, 5}, {1, 200}, {7, 11}};
+    for (const auto& [strideA, strideB] : shapes) {
+        IdSet a, b;
+        for (UserId i = 0; i < 1000; ++i) a.insert(i * strideA);
+        for (UserId i = 0; i < 1000 / (strideA == 1 ? 100 : 1); ++i) b.insert(i * strideB);
+
+        std::vector<UserId> expected;
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+
+        std::vector<UserId> actual;
+        EXPECT_EQ(IdSet::intersect(a, b, &actual), expected.size());
+        EXPECT_EQ(actual, expected);
+        EXPECT_EQ(IdSet::intersect(b, a), expected.size());
+    }
+}
+
+class MutualFriendsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Star around "hub": every spoke is a friend of hub, and spokes 0-2 also know "target"
+        hub = new User("hub", "hub@test.com", "pass");
+        target = new User("target", "target@test.com", "pass");
+        directory.addUser(hub);
+        directory.addUser(target);
+        for (int i = 0; i < 6; ++i) {
+            User* spoke = new User("spoke" + std::to_string(i), "spoke" + std::to_string(i) + "@test.com", "pass");
+            directory.addUser(spoke);
+            spokes.push_back(spoke);
+            befriend(hub, spoke);
+            if (i < 3) befriend(target, spoke);
+        }
+    }
+
+    void TearDown() override {
+        for (auto* spoke : spokes) delete spoke;
+        delete hub;
+        delete target;
+    }
+
+    static void befriend(User* a, User* b) {
+        a->addFriend(b->getId());
+        b->addFriend(a->getId());
+    }
+
+    UserDirectory directory;
+    User* hub;
+    User* target;
+    std::vector<User*> spokes;
+};
+
+TEST_F(MutualFriendsTest, MutualFriendsResolveThroughDirectory) {
+    MutualFriends engine(directory);
+    auto mutual = engine.mutualFriends(*hub, *target);
+    ASSERT_EQ(mutual.size(), 3);
+    EXPECT_EQ(mutual[0], spokes[0]);
+    EXPECT_EQ(engine.countMutualFriends(*hub, *target), 3);
+
+    hub->restrictFriend(spokes[1]->getId());
+    EXPECT_EQ(engine.countMutualFriends(*hub, *target), 2);
+}
+
+TEST_F(MutualFriendsTest, SuggestionsRankByMutualCount) {
+    MutualFriends engine(directory);
+    auto suggestions = engine.suggestFriends(*hub, 5);
+    ASSERT_EQ(suggestions.size(), 1);
+    EXPECT_EQ(suggestions[0].user, target);
+    EXPECT_EQ(suggestions[0].mutualCount, 3);
+
+    // spoke0 shares both hub and target with spokes 1-2, but only hub with spokes 3-5
+    auto fromSpoke = engine.suggestFriends(*spokes[0], 3);
+    ASSERT_EQ(fromSpoke.size(), 3);
+    EXPECT_EQ(fromSpoke[0].user, spokes[1]);
+    EXPECT_EQ(fromSpoke[0].mutualCount, 2);
+    EXPECT_EQ(fromSpoke[1].user, spokes[2]);
+    EXPECT_EQ(fromSpoke[2].mutualCount, 1);
+
+    // Blocked users are never suggested
+    hub->blockUser(target->getId());
+    EXPECT_TRUE(engine.suggestFriends(*hub, 5).empty());
+}
+
+TEST_F(MutualFriendsTest, ParallelAggregationMatchesSerial) {
+    MutualFriends engine(directory);
+    auto serial = engine.suggestFriends(*spokes[3], 10, 1);
+    auto parallel = engine.suggestFriends(*spokes[3], 10, 4);
+    ASSERT_EQ(serial.size(), parallel.size());
+    for (std::size_t i = 0; i < serial.size(); ++i) {
+        EXPECT_EQ(serial[i].user, parallel[i].user);
+        EXPECT_EQ(serial[i].mutualCount, parallel[i].mutualCount);
+    }
+}
+
+TEST_F(UserDirectoryTest, TypeAheadSearch) {
+    User* mona = new User("Mona", "mona@example.com", "pass");
+    directory.addUser(mona);
+
+    // Prefix matches on username come first and are case-insensitive
+    auto results = directory.search("mo");
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_EQ(results[0], user2);
+    EXPECT_EQ(results[1], mona);
+    EXPECT_EQ(directory.search("MO", 1).size(), 1);
+
+    // Infix matches through the trigram index, on username or email
+    EXPECT_EQ(directory.search("med").size(), 2);
+    EXPECT_EQ(directory.search("hamed"), (std::vector<User*>{user2}));
+    EXPECT_EQ(directory.search("example"), (std::vector<User*>{mona}));
+    EXPECT_TRUE(directory.search("xyz").empty());
+    EXPECT_EQ(directory.search("").size(), 3);
+
+    // Renames are reflected immediately
+    mona->setUsername("Zeina");
+    EXPECT_EQ(directory.search("mo").size(), 2); // still found by email prefix
+    EXPECT_EQ(directory.search("zei"), (std::vector<User*>{mona}));
+
+    directory.getSearchIndex().setInfixEnabled(false);
+    EXPECT_TRUE(directory.search("med").empty());
+    directory.getSearchIndex().setInfixEnabled(true);
+    EXPECT_EQ(directory.search("med").size(), 2);
+
+    delete mona;
+    EXPECT_TRUE(directory.search("zei").empty());
+}
+
+TEST_F(UserDirectoryTest, InfixSearchStopsAtLimit) {
+    // Every user shares the trigrams of ".com"; only some contain "x7q"
+    std::vector<User*> created;
+    for (int i = 0; i < 200; ++i) {
+        std::string name = "member" + std::to_string(i) + (i % 50 == 7 ? "x7q" : "");
+        created.push_back(new User(name, name + "@mail.com", "pass"));
+        directory.addUser(created.back());
+    }
+
+    EXPECT_EQ(directory.search("l.com", 5).size(), 5);
+    EXPECT_EQ(directory.search("l.com").size(), 200);
+
+    auto rare = directory.search("7x7q@ma");
+    ASSERT_EQ(rare.size(), 4);
+    for (User* user : rare) {
+        EXPECT_NE(user->getUsername().find("7x7q"), std::string::npos);
+    }
+    EXPECT_EQ(directory.search("7x7q@ma", 2).size(), 2);
+
+    for (User* user : created) {
+        delete user;
+    }
+}
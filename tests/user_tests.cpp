@@ -2,6 +2,7 @@
 #include <fstream>
 #include <filesystem>
 #include "../include/User.h"
+#include "../include/UserDirectory.h"
 #include "../include/Post.h"
 #include "../include/Comment.h"
 #include "../include/Conversation.h"
@@ -218,6 +219,9 @@ protected:
     void SetUp() override {
         user1 = new User("user1", "user1@test.com", "pass123");
         user2 = new User("user2", "user2@test.com", "pass123");
+        // Mutual friends are resolved through a directory
+        directory.addUser(user1);
+        directory.addUser(user2);
     }
 
     void TearDown() override {
@@ -225,12 +229,14 @@ protected:
         delete user2;
     }
 
+    UserDirectory directory;
     User* user1;
     User* user2;
 };
 
 TEST_F(UserTest_MutualFriends_Test, TestBody) {
     User* user3 = new User("user3", "user3@test.com", "pass123", "male");
+    directory.addUser(user3);
     
     user1->addFriend(user2->getUsername());
     user2->addFriend(user1->getUsername());
@@ -296,6 +302,9 @@ protected:
     void SetUp() override {
         user1 = new User("user1", "user1@test.com", "pass123");
         user2 = new User("user2", "user2@test.com", "pass123");
+        // Mutual friends are resolved through a directory
+        directory.addUser(user1);
+        directory.addUser(user2);
     }
 
     void TearDown() override {
@@ -303,6 +312,7 @@ protected:
         delete user2;
     }
 
+    UserDirectory directory;
     User* user1;
     User* user2;
 };
@@ -310,6 +320,8 @@ protected:
 TEST_F(UserTest_OperatorAnd_Test, TestBody) {
     User* user3 = new User("user3", "user3@test.com", "pass123", "male");
     User* user4 = new User("user4", "user4@test.com", "pass123", "female");
+    directory.addUser(user3);
+    directory.addUser(user4);
     
     // Test when users are not friends
     std::vector<User*> mutualFriends = *user1 & *user2;